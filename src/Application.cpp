@@ -1,8 +1,19 @@
 #include "Game.h"
 
-int main(int argc, char** args[])
+int main(int argc, char* args[])
 {
+	// "--cook" rebuilds the texture cache and exits.
+	if (argc > 1 && std::string(args[1]) == "--cook")
+	{
+		return Game::CookAssets() ? 0 : 1;
+	}
+
+
 	Game game(800.0f, 600.0f);
+	if (!game.IsInitialized())
+	{
+		return 1;
+	}
 	game.run();
 
 	return 0;
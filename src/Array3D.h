@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <cstring>
+
 template <typename T>
 class Array3D
 {
@@ -12,14 +15,14 @@ public:
 	Array3D(const Array3D<T>& other)
 	{
 		Init(other.X, other.Y, other.Z);
-		memcpy(Data, other.Data, X * Y * Z);
+		memcpy(Data, other.Data, sizeof(T) * X * Y * Z);
 	}
 	Array3D(Array3D<T>&& other) noexcept
 		: X(other.X), Y(other.Y), Z(other.Z), Data(other.Data)
 	{
 		other.X = 0;
+		other.Y = 0;
 		other.Z = 0;
-		other.X = 0;
 		other.Data = nullptr;
 	}
 	
@@ -34,6 +37,30 @@ public:
 	void Delete()
 	{
 		delete[] Data;
+		Data = nullptr;
+	}
+
+	// Takes ownership of storage allocated with new T[x * y * z].
+	void Adopt(T* data, unsigned x, unsigned y, unsigned z)
+	{
+		Delete();
+		X = x;
+		Y = y;
+		Z = z;
+		Data = data;
+	}
+
+	// Gives up ownership of the storage, the array is left unallocated.
+	T* Release()
+	{
+		T* const data = Data;
+		Data = nullptr;
+		return data;
+	}
+
+	bool IsAllocated() const
+	{
+		return Data != nullptr;
 	}
 
 	T& at(int x, int y, int z)
@@ -50,3 +77,178 @@ private:
 	T* Data;
 	unsigned X, Y, Z;
 };
+
+// Layout policies for FixedArray3D, each maps (x, y, z) to an element index with shifts,
+// ORs and table lookups only. Dimensions are powers of two.
+namespace ArrayLayout
+{
+	constexpr unsigned Log2(unsigned value)
+	{
+		return value > 1 ? 1 + Log2(value >> 1) : 0;
+	}
+
+	// x-major, z runs fastest. Neighbours along an axis are a constant step apart.
+	template <unsigned X, unsigned Y, unsigned Z>
+	struct Linear
+	{
+		static constexpr unsigned StepZ = 1u;
+		static constexpr unsigned StepY = Z;
+		static constexpr unsigned StepX = Y * Z;
+
+		static constexpr unsigned Index(unsigned x, unsigned y, unsigned z)
+		{
+			return (x << Log2(StepX)) | (y << Log2(StepY)) | z;
+		}
+	};
+
+	// Bit b of a coordinate along axis (0 = z, 1 = y, 2 = x) moves to its slot in round b of
+	// the interleave, z first. Axes run out of bits independently when they differ in size.
+	constexpr unsigned MortonSpread(unsigned value, unsigned axis, const unsigned (&bits)[3])
+	{
+		unsigned result = 0;
+		unsigned position = 0;
+		for (unsigned bit{}; bit < bits[0] || bit < bits[1] || bit < bits[2]; ++bit)
+		{
+			for (unsigned a{}; a < 3; ++a)
+			{
+				if (bit < bits[a])
+				{
+					if (a == axis)
+					{
+						result |= ((value >> bit) & 1u) << position;
+					}
+					++position;
+				}
+			}
+		}
+		return result;
+	}
+
+	template <unsigned Count, unsigned X, unsigned Y, unsigned Z>
+	constexpr std::array<unsigned, Count> MortonTable(unsigned axis)
+	{
+		constexpr unsigned bits[3] = { Log2(Z), Log2(Y), Log2(X) };
+		std::array<unsigned, Count> table{};
+		for (unsigned i{}; i < Count; ++i)
+		{
+			table[i] = MortonSpread(i, axis, bits);
+		}
+		return table;
+	}
+
+	// Z-order curve, the bits of x, y and z are interleaved so any small cube of cells
+	// is close together in memory.
+	template <unsigned X, unsigned Y, unsigned Z>
+	struct Morton
+	{
+		static constexpr unsigned Index(unsigned x, unsigned y, unsigned z)
+		{
+			return SpreadX[x] | SpreadY[y] | SpreadZ[z];
+		}
+
+	private:
+		static constexpr std::array<unsigned, Z> SpreadZ = MortonTable<Z, X, Y, Z>(0);
+		static constexpr std::array<unsigned, Y> SpreadY = MortonTable<Y, X, Y, Z>(1);
+		static constexpr std::array<unsigned, X> SpreadX = MortonTable<X, X, Y, Z>(2);
+	};
+
+	// 4x4x4 bricks laid out x-major, cells inside a brick too. A brick is 64 elements,
+	// a single cache line for byte sized blocks.
+	template <unsigned X, unsigned Y, unsigned Z>
+	struct Brick
+	{
+		static_assert(X >= 4 && Y >= 4 && Z >= 4, "Bricks need every dimension to be at least 4.");
+
+		static constexpr unsigned Index(unsigned x, unsigned y, unsigned z)
+		{
+			const unsigned brick = Linear<X / 4, Y / 4, Z / 4>::Index(x >> 2, y >> 2, z >> 2);
+			const unsigned cell = Linear<4, 4, 4>::Index(x & 3u, y & 3u, z & 3u);
+			return (brick << 6) | cell;
+		}
+	};
+}
+
+// Array3D with power of two dimensions known at compile time, indexing is shifts and ORs.
+// The memory layout is a policy, with Linear stepping to a neighbour along an axis is a
+// constant offset (Policy::StepX and so on).
+template <typename T, unsigned X, unsigned Y, unsigned Z, template <unsigned, unsigned, unsigned> class LayoutPolicy = ArrayLayout::Linear>
+class FixedArray3D
+{
+	static_assert(X > 0 && (X & (X - 1)) == 0, "X must be a power of two.");
+	static_assert(Y > 0 && (Y & (Y - 1)) == 0, "Y must be a power of two.");
+	static_assert(Z > 0 && (Z & (Z - 1)) == 0, "Z must be a power of two.");
+
+public:
+	using Policy = LayoutPolicy<X, Y, Z>;
+	static constexpr unsigned SizeX = X;
+	static constexpr unsigned SizeY = Y;
+	static constexpr unsigned SizeZ = Z;
+	static constexpr unsigned Volume = X * Y * Z;
+
+	static constexpr unsigned Index(unsigned x, unsigned y, unsigned z)
+	{
+		return Policy::Index(x, y, z);
+	}
+
+	FixedArray3D() : Data(nullptr) {}
+	FixedArray3D(const FixedArray3D&) = delete;
+	FixedArray3D& operator=(const FixedArray3D&) = delete;
+	~FixedArray3D()
+	{
+		Delete();
+	}
+
+	void Init()
+	{
+		Adopt(new T[Volume]);
+	}
+
+	void Delete()
+	{
+		delete[] Data;
+		Data = nullptr;
+	}
+
+	// Takes ownership of storage allocated with new T[Volume].
+	void Adopt(T* data)
+	{
+		Delete();
+		Data = data;
+	}
+
+	// Gives up ownership of the storage, the array is left unallocated.
+	T* Release()
+	{
+		T* const data = Data;
+		Data = nullptr;
+		return data;
+	}
+
+	bool IsAllocated() const
+	{
+		return Data != nullptr;
+	}
+
+	T* data()
+	{
+		return Data;
+	}
+
+	const T* data() const
+	{
+		return Data;
+	}
+
+	T& at(unsigned x, unsigned y, unsigned z)
+	{
+		return Data[Index(x, y, z)];
+	}
+
+	const T& at(unsigned x, unsigned y, unsigned z) const
+	{
+		return Data[Index(x, y, z)];
+	}
+
+private:
+	T* Data;
+};
@@ -0,0 +1,207 @@
+#include "BlockRegistry.h"
+#include "helpers.h"
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+std::array<uint8_t, BlockRegistry::MaxBlocks> BlockRegistry::Flags{};
+std::array<uint8_t, BlockRegistry::MaxBlocks> BlockRegistry::Emission{};
+std::array<std::array<uint16_t, 6>, BlockRegistry::MaxBlocks> BlockRegistry::Layers{};
+std::array<std::array<GLuint, 6>, BlockRegistry::MaxBlocks> BlockRegistry::Tints{};
+std::array<std::string, BlockRegistry::MaxBlocks> BlockRegistry::Names;
+std::vector<Vertex> BlockRegistry::CubeVertices;
+unsigned BlockRegistry::Count = 0;
+
+bool BlockRegistry::Load(const char* path, unsigned tilesPerRow, unsigned layerCount)
+{
+	Reset();
+
+	const std::string content = GetFileContent(path);
+	if (content.empty())
+	{
+		PrintError("Couldn't load the block registry.");
+		return false;
+	}
+
+	std::istringstream lines(content);
+	std::string line;
+	unsigned number = 0;
+	bool valid = true;
+	while (std::getline(lines, line))
+	{
+		++number;
+		const size_t comment = line.find('#');
+		if (comment != std::string::npos)
+		{
+			line.erase(comment);
+		}
+		if (line.find_first_not_of(" \t\r") == std::string::npos)
+		{
+			continue;
+		}
+
+		if (!ParseLine(line, tilesPerRow, layerCount))
+		{
+			PrintError(("Bad block definition on line " + std::to_string(number) + " of the block registry.").c_str());
+			valid = false;
+		}
+	}
+
+	// The terrain generator and the editor rely on these.
+	for (CubeType type : { CubeType::DIRT, CubeType::GRASS, CubeType::EMPTY })
+	{
+		if (Names[type].empty())
+		{
+			PrintError("The block registry is missing a built-in block.");
+			valid = false;
+		}
+	}
+	if (Flags[CubeType::EMPTY] != 0)
+	{
+		PrintError("The empty block must not be visible, solid or opaque.");
+		valid = false;
+	}
+	return valid;
+}
+
+CubeType BlockRegistry::Find(const std::string& name)
+{
+	for (unsigned id{}; id < MaxBlocks; ++id)
+	{
+		if (Names[id] == name)
+		{
+			return static_cast<CubeType>(id);
+		}
+	}
+	return CubeType::EMPTY;
+}
+
+const std::string& BlockRegistry::GetName(CubeType type)
+{
+	return Names[type];
+}
+
+unsigned BlockRegistry::GetCount()
+{
+	return Count;
+}
+
+bool BlockRegistry::ParseLine(const std::string& line, unsigned tilesPerRow, unsigned layerCount)
+{
+	std::istringstream tokens(line);
+	unsigned id;
+	std::string name;
+	if (!(tokens >> id >> name) || id >= MaxBlocks || !Names[id].empty())
+	{
+		return false;
+	}
+
+	uint8_t flags = 0;
+	unsigned emission = 0;
+	std::vector<GLuint> tiles;
+	glm::vec3 tint(1.0f);
+	glm::vec3 tintTop(-1.0f);
+
+	std::string token;
+	while (tokens >> token)
+	{
+		if (token == "solid")
+		{
+			flags |= BLOCK_SOLID;
+		}
+		else if (token == "opaque")
+		{
+			flags |= BLOCK_OPAQUE;
+		}
+		else if (token == "light")
+		{
+			if (!(tokens >> emission) || emission > 15)
+			{
+				return false;
+			}
+		}
+		else if (token == "tint" || token == "tint-top")
+		{
+			glm::vec3& color = token == "tint" ? tint : tintTop;
+			if (!(tokens >> color.r >> color.g >> color.b))
+			{
+				return false;
+			}
+		}
+		else if (token == "tiles")
+		{
+			// Tiles run until the next keyword.
+			while (tokens >> std::ws && std::isdigit(tokens.peek()))
+			{
+				unsigned column, row;
+				char comma;
+				if (!(tokens >> column >> comma >> row) || comma != ',')
+				{
+					return false;
+				}
+				// Widened, a huge row would wrap around back into the atlas.
+				if (column >= tilesPerRow || static_cast<uint64_t>(row) * tilesPerRow + column >= layerCount)
+				{
+					return false;
+				}
+				tiles.emplace_back(row * tilesPerRow + column);
+			}
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// One tile for every face, side bottom top, or one per Side.
+	std::array<GLuint, 6> layers{};
+	switch (tiles.size())
+	{
+	case 0:
+		break;
+	case 1:
+		layers.fill(tiles[0]);
+		break;
+	case 3:
+		layers = { tiles[0], tiles[0], tiles[0], tiles[0], tiles[1], tiles[2] };
+		break;
+	case 6:
+		std::copy(tiles.begin(), tiles.end(), layers.begin());
+		break;
+	default:
+		return false;
+	}
+	if (!tiles.empty())
+	{
+		flags |= BLOCK_VISIBLE;
+	}
+
+	Names[id] = name;
+	Flags[id] = flags;
+	Emission[id] = static_cast<uint8_t>(emission);
+	for (unsigned side{}; side < 6; ++side)
+	{
+		Layers[id][side] = static_cast<uint16_t>(layers[side]);
+		Tints[id][side] = Vertex::PackColor(side == Side::TOP && tintTop.r >= 0.0f ? tintTop : tint);
+	}
+	++Count;
+	return true;
+}
+
+void BlockRegistry::Reset()
+{
+	Flags.fill(0);
+	Emission.fill(0);
+	for (std::array<uint16_t, 6>& layers : Layers)
+	{
+		layers.fill(0);
+	}
+	for (std::array<GLuint, 6>& tints : Tints)
+	{
+		tints.fill(0xFFFFFFFFu);
+	}
+	Names.fill(std::string());
+	Count = 0;
+
+	CubeVertices = TextureData::GetVerticesFormatted();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "GLAD/glad.h"
+#include "TextureData.h"
+#include "Vertex.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+enum BlockFlags : uint8_t
+{
+	BLOCK_VISIBLE = 0x01, // Has tiles and gets meshed.
+	BLOCK_SOLID = 0x02, // Stops raycasts.
+	BLOCK_OPAQUE = 0x04, // Hides the faces of its neighbours.
+};
+
+// Block types read from a data file at startup into flat tables indexed by block id,
+// the CubeType value stored in chunks. Hot loops only ever index these arrays.
+class BlockRegistry
+{
+public:
+	static constexpr unsigned MaxBlocks = 256u;
+
+	// Layers are resolved against an atlas with tilesPerRow tiles per row and layerCount layers,
+	// tiles outside it are bad definitions.
+	static bool Load(const char* path, unsigned tilesPerRow, unsigned layerCount);
+
+	// EMPTY when there is no block with that name.
+	static CubeType Find(const std::string& name);
+	static const std::string& GetName(CubeType type);
+	static unsigned GetCount();
+
+	static bool IsVisible(CubeType type)
+	{
+		return (Flags[type] & BLOCK_VISIBLE) != 0;
+	}
+
+	static bool IsSolid(CubeType type)
+	{
+		return (Flags[type] & BLOCK_SOLID) != 0;
+	}
+
+	static bool IsOpaque(CubeType type)
+	{
+		return (Flags[type] & BLOCK_OPAQUE) != 0;
+	}
+
+	// Block light the block gives off, 0 to 15.
+	static uint8_t GetLightEmission(CubeType type)
+	{
+		return Emission[type];
+	}
+
+	// Terrain texture array layer of the tile used by the side.
+	static GLuint GetLayer(CubeType type, Side side)
+	{
+		return Layers[type][side];
+	}
+
+	// RGBA8, see Vertex::Tint.
+	static GLuint GetTint(CubeType type, Side side)
+	{
+		return Tints[type][side];
+	}
+
+	// Corner of the unit cube with the block's layer and tint, 4 corners per Side.
+	static Vertex GetFaceVertex(CubeType type, Side side, unsigned corner)
+	{
+		Vertex vertex = CubeVertices[side * 4 + corner];
+		vertex.Texture.z = static_cast<GLfloat>(Layers[type][side]);
+		vertex.Tint = Tints[type][side];
+		return vertex;
+	}
+
+private:
+	BlockRegistry() {}
+
+	static bool ParseLine(const std::string& line, unsigned tilesPerRow, unsigned layerCount);
+	static void Reset();
+
+private:
+	static std::array<uint8_t, MaxBlocks> Flags;
+	static std::array<uint8_t, MaxBlocks> Emission;
+	static std::array<std::array<uint16_t, 6>, MaxBlocks> Layers;
+	static std::array<std::array<GLuint, 6>, MaxBlocks> Tints;
+	static std::array<std::string, MaxBlocks> Names;
+	static std::vector<Vertex> CubeVertices;
+	static unsigned Count;
+};
@@ -1,27 +1,120 @@
 #include "Chunk.h"
 #include "World.h"
+#include "ChunkPool.h"
+#include "LightEngine.h"
+#include <algorithm>
+#include <cstring>
 
 #define TIMER 0
 
-Chunk::Chunk(const glm::vec2& position, unsigned size)
-	: ChunkPosition(position), Size_X(size), Size_Z(size)
+Chunk::Chunk(const glm::vec2& position)
 {
-	Position = glm::vec3(position.x * Size_X, 0.0f, position.y * Size_Z);
-	Cubes.Init(Size_X, Size_Z, Size_Y);
+	Reset(position);
 }
 
 Chunk::~Chunk()
 {
+	Clear();
 }
 
-void Chunk::Render(const ShaderProgram& shader, const Camera& camera, const glm::mat4& proj)
+void Chunk::Render(const ShaderProgram& shader, const Camera& camera, const glm::mat4& proj, unsigned sections, bool cullSides, GLint useLightVolume)
 {
+	if ((sections & DrawMask) == 0)
+	{
+		return;
+	}
+
+	// Faces are grouped by Side, the groups facing away from the camera everywhere in the chunk
+	// or section box are left out. The box is bounded by the blocks' outer faces.
+	const glm::vec3 low = Position - 0.5f;
+	const glm::vec3 high = Position + glm::vec3(SizeX, 0.0f, SizeZ) - 0.5f;
+	const glm::vec3& eye = camera.pos;
+	const unsigned columnSides = !cullSides ? 0x3Fu :
+		(eye.z > low.z) << Side::FRONT | (eye.z < high.z) << Side::BACK |
+		(eye.x < high.x) << Side::LEFT | (eye.x > low.x) << Side::RIGHT;
+
+	// Every requested non-empty section in a single call. Draws are kept sorted by section,
+	// they are walked outwards from the camera's section so nearer faces get drawn first.
+	const int cameraSection = std::clamp(static_cast<int>(std::floor((eye.y + 0.5f) / ChunkSection::Size)), 0, static_cast<int>(SectionCount) - 1);
+	int above = 0;
+	while (above < static_cast<int>(DrawCount) && DrawSections[above] < cameraSection)
+	{
+		++above;
+	}
+	int below = above - 1;
+
+	std::array<GLsizei, SectionCount * 6> counts;
+	std::array<const void*, SectionCount * 6> offsets;
+	std::array<GLint, SectionCount * 6> baseVertices;
+	GLsizei count = 0;
+	while (below >= 0 || above < static_cast<int>(DrawCount))
+	{
+		const bool takeBelow = above >= static_cast<int>(DrawCount) ||
+			(below >= 0 && cameraSection - DrawSections[below] <= DrawSections[above] - cameraSection);
+		const unsigned draw = takeBelow ? below-- : above++;
+		if (!(sections & (1u << DrawSections[draw])))
+		{
+			continue;
+		}
+
+		const float bottom = DrawSections[draw] * static_cast<float>(ChunkSection::Size) - 0.5f;
+		const unsigned sides = columnSides | (!cullSides ? 0x3Fu :
+			(eye.y < bottom + ChunkSection::Size) << Side::BOTTOM | (eye.y > bottom) << Side::TOP);
+
+		// Neighbouring groups that are both drawn share one draw.
+		const MeshRange& range = DrawRanges[draw];
+		GLsizei first = range.firstIndex;
+		bool joined = false;
+		for (unsigned side{}; side < 6; ++side)
+		{
+			const GLsizei sideCount = range.sideIndexCounts[side];
+			if (sideCount == 0)
+			{
+				continue;
+			}
+			if (!(sides & (1u << side)))
+			{
+				joined = false;
+			}
+			else if (joined)
+			{
+				counts[count - 1] += sideCount;
+			}
+			else
+			{
+				counts[count] = sideCount;
+				offsets[count] = reinterpret_cast<const void*>(static_cast<uintptr_t>(first) * sizeof(GLuint));
+				baseVertices[count] = range.baseVertex;
+				++count;
+				joined = true;
+			}
+			first += sideCount;
+		}
+	}
+	if (count == 0)
+	{
+		return;
+	}
+
 	shader.Bind();
-	shader.SetLights(NO_LIGHT);
-	shader.BindUniformVec3("viewPos", camera.pos);
+	if (shader.IsLit())
+	{
+		shader.BindUniformVec3("viewPos", camera.pos);
+	}
 
-	// Material Uniform.
+	// Material Uniform, tint and tile are per vertex so it is shared by every block type.
 	BindTextures();
+	shader.BindMaterial(material);
+
+	const bool lightVolume = useLightVolume != -1 && Lod == 0 && LightTexture.ID != 0;
+	if (lightVolume)
+	{
+		LightTexture.Bind();
+	}
+	if (useLightVolume != -1)
+	{
+		shader.BindUniform1i(useLightVolume, lightVolume);
+	}
 
 	// MVP uniform.
 	shader.BindUniformMat4("view", glm::value_ptr(camera.view));
@@ -29,292 +122,1117 @@ void Chunk::Render(const ShaderProgram& shader, const Camera& camera, const glm:
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::translate(model, Position);
 	shader.BindUniformMat4("model", glm::value_ptr(model));
-
-	for (const auto& entry : blockTypeVertices)
+	if (shader.IsLit())
 	{
-		buffers.at(entry.first).vao.Bind();
-		shader.BindMaterial(blockTypeMaterial.at(entry.first));
-		glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(blockTypeIndices.at(entry.first).size()), GL_UNSIGNED_INT, 0);
-		buffers.at(entry.first).vao.Unbind();
+		const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+		shader.BindUniformMat3("normalMatrix", glm::value_ptr(normalMatrix));
 	}
 
+	Mesh.vao.Bind();
+	glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), count, baseVertices.data());
+	Mesh.vao.Unbind();
+
 	shader.Unbind();
 	UnbindTextures();
+	if (lightVolume)
+	{
+		LightTexture.Unbind();
+	}
 }
 
 void Chunk::Delete()
 {
-	DeleteBuffers();
-	DeleteTextures();
+	// Textures are shared and owned by the ResourceManager, the light volume is the chunk's own.
+	DeleteMesh();
+	DeleteLightVolume();
 }
 
-std::pair<int, int> Chunk::getKey() const
+void Chunk::Clear()
 {
-	return std::pair<int, int>(ChunkPosition.x, ChunkPosition.y);
+	DeleteMesh();
+	DeleteLightVolume();
+	ChunkPool::ReleaseSections(std::move(Sections));
+	Blocks.Clear();
+	Compressed = true;
+	Lighting = LIGHT_NONE;
+	Meshed = false;
 }
 
-void Chunk::GenerateData()
+void Chunk::Reset(const glm::vec2& position)
 {
-	float* const heightMap = GenChunk();
-
-	GenBlocks(heightMap);
-	delete[] heightMap;
-	GenFaces();
-	Cubes.Delete();
-	GenBuffersData();
+	ChunkPosition = position;
+	Position = glm::vec3(position.x * SizeX, 0.0f, position.y * SizeZ);
+	Blocks.Init(SizeX, SizeY, SizeZ);
+	Compressed = true;
+	UnsavedEdits = false;
+	Meshed = false;
+	Lod = 0;
+	NeighbourMask = 0;
+	Lighting = LIGHT_NONE;
+	MeshQueued = false;
+	LightQueued = false;
 }
 
-void Chunk::GenerateOpenGLData()
+std::pair<int, int> Chunk::getKey() const
 {
-	GenAllBuffers();
-	DeleteBuffersData();
+	return std::pair<int, int>(ChunkPosition.x, ChunkPosition.y);
 }
 
-float* const Chunk::GenChunk()
+void Chunk::GenerateData(const std::string& savePath)
 {
-	float* const heightMap = new float[Size_X * Size_Z];
-	const float scale = 0.01f;
-	const int32_t octaves = 3;
-
-	for (unsigned x{}; x < Size_X; ++x)
+	if (Blocks.Load(savePath, SizeX, SizeY, SizeZ))
 	{
-		for (unsigned z{}; z < Size_Z; ++z)
-		{
-			double uniqueX = (Position.x + x) * scale;
-			double uniqueZ = (Position.z + z) * scale;
+		// Edited terrain, the sky tops are scanned from the blocks.
+		Decompress();
+		LightEngine::LightChunk(*this);
+	}
+	else
+	{
+		float* const heightMap = GenChunk();
 
-			const float perlin = static_cast<float>(perlinNoise.octave2D_01(uniqueX, uniqueZ, octaves));
-			heightMap[x * Size_Z + z] = perlin * Size_Y;
-		}
+		GenBlocks(heightMap);
+		const std::array<uint16_t, SizeX * SizeZ> skyTops = GetSkyTops(heightMap);
+		delete[] heightMap;
+		Decompress();
+		LightEngine::LightChunk(*this, skyTops.data());
 	}
-	return heightMap;
+
+	Textures.clear();
+	Textures.insert(ResourceManager::GetTextureArray("atlas-1"));
+	material.diffuse = ResourceManager::GetTextureArray("atlas-1").unit;
 }
 
-void Chunk::GenBlocks(float* const heightMap)
+void Chunk::GenerateMesh(unsigned lod, const std::array<Chunk*, 4>& neighbours, bool bakeLight, bool perBlockLookup)
 {
 #if TIMER
-	Timer timer("GenBlocks");
+	Timer timer("GenerateMesh");
 #endif
 
-	static const Cube grassCube(CubeType::GRASS);
-	static const Cube dirtCube(CubeType::DIRT);
-	static const Cube emptyCube(CubeType::EMPTY);
+	Lod = lod;
+	NeighbourMask = 0;
+	for (unsigned side{}; side < neighbours.size(); ++side)
+	{
+		if (neighbours[side])
+		{
+			NeighbourMask |= 1u << side;
+		}
+	}
 
-	blockTypeMaterial.clear();
-	blockTypeMaterial[CubeType::GRASS] = grassCube.GetMaterial();
-	blockTypeMaterial[CubeType::DIRT] = dirtCube.GetMaterial();
+	UpdateOccluders();
 
-	for (unsigned x{}; x < Size_X; ++x)
+	if (lod == 0)
 	{
-		for (unsigned z{}; z < Size_Z; ++z)
+		LightBaked = bakeLight;
+		for (unsigned index{}; index < SectionCount; ++index)
 		{
-			const int height = static_cast<int>(heightMap[x * Size_Z + z]);
-			const float posX = static_cast<float>(x);
-			const float posZ = static_cast<float>(z);
+			ChunkSection& section = Sections[index];
+			if (!section.Dirty.exchange(false))
+			{
+				continue;
+			}
 
-			for (unsigned y{}; y < Size_Y; ++y)
+			section.BeginMesh();
+			section.UpdateVisibility();
+			if (!section.IsEmpty() && !IsSectionOccluded(index, neighbours))
 			{
-				const float posY = static_cast<float>(y);
-				if (y == height - 1)
+				thread_local PaddedSection<ChunkSection::Size> padded;
+				if (perBlockLookup)
 				{
-					Cubes.at(x, z, y) = grassCube;
-					Cubes.at(x, z, y).MoveVertices(glm::vec3(posX, posY, posZ));
-				}
-				else if (y < height - 1)
-				{
-					Cubes.at(x, z, y) = dirtCube;
-					Cubes.at(x, z, y).MoveVertices(glm::vec3(posX, posY, posZ));
+					FillPaddedPerBlock(padded, index, neighbours, bakeLight);
 				}
 				else
 				{
-					Cubes.at(x, z, y) = emptyCube;
+					FillPadded(padded, index, neighbours, bakeLight);
 				}
+				GenFaces(section, padded, index);
 			}
+			section.FinishMesh();
 		}
+		return;
 	}
+
+	// Distant chunks are meshed from downsampled blocks, their borders are always closed.
+	const unsigned scale = 1u << lod;
+	RLEChunk blocks;
+	Encode(blocks);
+	const RLEChunk coarse = blocks.Downsample(scale);
+	Array3D<CubeType> dense(coarse.SizeX(), coarse.SizeZ(), coarse.SizeY());
+	coarse.ToDense(dense);
+
+	const int sizeX = static_cast<int>(coarse.SizeX());
+	const int sizeY = static_cast<int>(coarse.SizeY());
+	const int sizeZ = static_cast<int>(coarse.SizeZ());
+	const auto blockAt = [&dense, sizeX, sizeY, sizeZ](int x, int y, int z) {
+		if (y < 0)
+		{
+			return CubeType::DIRT;
+		}
+		if (x < 0 || x >= sizeX || y >= sizeY || z < 0 || z >= sizeZ)
+		{
+			return CubeType::EMPTY;
+		}
+		return dense.at(x, z, y);
+		};
+
+	for (unsigned index{}; index < SectionCount; ++index)
+	{
+		ChunkSection& section = Sections[index];
+		if (!section.Dirty.exchange(false))
+		{
+			continue;
+		}
+
+		// Each size is its own instantiation, so the strides stay constants.
+		// Visibility still comes from the full detail blocks.
+		section.BeginMesh();
+		section.UpdateVisibility();
+		switch (scale)
+		{
+		case 2u:
+			GenLodFaces<ChunkSection::Size / 2u>(section, index, blockAt);
+			break;
+		case 4u:
+			GenLodFaces<ChunkSection::Size / 4u>(section, index, blockAt);
+			break;
+		case 8u:
+			GenLodFaces<ChunkSection::Size / 8u>(section, index, blockAt);
+			break;
+		default:
+			GenLodFaces<ChunkSection::Size / 16u>(section, index, blockAt);
+			break;
+		}
+		section.FinishMesh();
+	}
+	dense.Delete();
 }
 
-void Chunk::GenBuffersData()
+void Chunk::GenerateOpenGLData()
 {
 #if TIMER
-	Timer timer("GenBuffersData");
+	Timer timer("GenerateOpenGLData");
 #endif
 
-	for (const auto& [type, vertices] : blockTypeVertices)
+	OccluderHeights = PendingOccluderHeights;
+
+	size_t vertexCount = 0;
+	bool pending = false;
+	for (unsigned index{}; index < SectionCount; ++index)
+	{
+		const ChunkSection& section = Sections[index];
+		if (section.HasPendingMesh())
+		{
+			pending = true;
+			const MeshData* mesh = section.GetPendingMesh();
+			vertexCount += mesh ? mesh->Vertices.size() : 0;
+		}
+		else
+		{
+			vertexCount += section.GetRange().vertexCount;
+		}
+	}
+
+	if (!pending)
+	{
+		Meshed = true;
+		return;
+	}
+
+	// Sections are packed into a new set, remeshed ones from the CPU and the rest copied over on the GPU.
+	// The previous set stays drawable until this one is complete.
+	Buffers buffers;
+	if (vertexCount > 0)
+	{
+		buffers = MeshPool::AcquireBuffers(vertexCount);
+	}
+
+	GLint firstVertex = 0;
+	GLsizei firstIndex = 0;
+	for (unsigned index{}; index < SectionCount; ++index)
 	{
-		const unsigned size = static_cast<unsigned>(vertices.size()) * 8u;
-		GLfloat* verts = new GLfloat[size];
+		ChunkSection& section = Sections[index];
+		MeshRange range;
+		range.baseVertex = firstVertex;
+		range.firstIndex = firstIndex;
 
-		int vertexCount = 0;
-		for (const Vertex& vertex : vertices)
+		if (section.HasPendingMesh())
 		{
-			memcpy(&verts[vertexCount], vertex.GetData(), sizeof(GLfloat) * 8);
-			vertexCount += 8;
+			if (const MeshData* mesh = section.GetPendingMesh())
+			{
+				range.vertexCount = static_cast<GLsizei>(mesh->Vertices.size());
+				range.indexCount = static_cast<GLsizei>(mesh->Indices.size());
+				range.sideIndexCounts = section.GetPendingSideCounts();
+				buffers.vbo.Update(mesh->Vertices.data(), range.vertexCount * sizeof(Vertex), range.baseVertex * sizeof(Vertex));
+				buffers.ebo.Update(mesh->Indices.data(), range.indexCount * sizeof(GLuint), range.firstIndex * sizeof(GLuint));
+			}
+			section.FinishUpload(range);
+		}
+		else if (const MeshRange& previous = section.GetRange(); previous.vertexCount > 0)
+		{
+			range.vertexCount = previous.vertexCount;
+			range.indexCount = previous.indexCount;
+			range.sideIndexCounts = previous.sideIndexCounts;
+			buffers.vbo.CopyFrom(Mesh.vbo, previous.baseVertex * sizeof(Vertex), range.baseVertex * sizeof(Vertex), range.vertexCount * sizeof(Vertex));
+			buffers.ebo.CopyFrom(Mesh.ebo, previous.firstIndex * sizeof(GLuint), range.firstIndex * sizeof(GLuint), range.indexCount * sizeof(GLuint));
+			section.FinishUpload(range);
 		}
 
-		BuffersData.try_emplace(type, verts, size);
+		firstVertex += range.vertexCount;
+		firstIndex += range.indexCount;
+	}
+	buffers.count = firstIndex;
+
+	if (buffers.vao.ID != 0)
+	{
+		buffers.vao.Unbind();
+		buffers.vbo.Unbind();
 	}
+	MeshPool::ReleaseBuffers(Mesh);
+	Mesh = buffers;
+	UpdateDrawRanges();
+	Meshed = true;
 }
 
-void Chunk::AddVertices(const CubeType& type, const std::vector<Vertex>& vertices)
+void Chunk::DeleteMesh()
 {
-	std::vector<Vertex>& verts = blockTypeVertices[type];
-	for (const Vertex& vertex : vertices)
+	if (Sections)
 	{
-		verts.emplace_back(vertex);
+		for (unsigned index{}; index < SectionCount; ++index)
+		{
+			Sections[index].DeleteMesh();
+		}
 	}
+	MeshPool::ReleaseBuffers(Mesh);
+	Mesh = Buffers();
+	DrawCount = 0;
+	DrawMask = 0;
+	OccluderHeights.fill(0);
+	Meshed = false;
 }
 
-void Chunk::AddIndices(const CubeType& type, unsigned faces)
+void Chunk::UpdateDrawRanges()
 {
-	unsigned count = blockTypeIndices[type].size() / 6;
-	unsigned offset = count * faces * 4;
-	std::vector<GLuint>& ids = blockTypeIndices.at(type);
-	for (unsigned i{}; i < faces; ++i)
+	DrawCount = 0;
+	DrawMask = 0;
+	for (unsigned index{}; index < SectionCount; ++index)
 	{
-		ids.emplace_back(offset);
-		ids.emplace_back(offset + 1);
-		ids.emplace_back(offset + 2);
-		ids.emplace_back(offset + 2);
-		ids.emplace_back(offset + 3);
-		ids.emplace_back(offset);
+		const MeshRange& range = Sections[index].GetRange();
+		if (range.indexCount == 0)
+		{
+			continue;
+		}
+		DrawRanges[DrawCount] = range;
+		DrawSections[DrawCount] = static_cast<uint8_t>(index);
+		DrawMask |= 1u << index;
+		++DrawCount;
+	}
+}
 
-		offset += 4;
+bool Chunk::HasMesh() const
+{
+	return Meshed;
+}
+
+void Chunk::MarkDirty()
+{
+	for (unsigned index{}; index < SectionCount; ++index)
+	{
+		Sections[index].Dirty = true;
 	}
 }
 
-void Chunk::BindTextures() const
+bool Chunk::IsDirty() const
 {
-	for (const Texture2D& texture : Textures)
+	for (unsigned index{}; index < SectionCount; ++index)
 	{
-		texture.Bind();
+		if (Sections[index].Dirty)
+		{
+			return true;
+		}
 	}
+	return false;
 }
 
-void Chunk::UnbindTextures() const
+unsigned Chunk::GetLod() const
 {
-	for (const Texture2D& texture : Textures)
+	return Lod;
+}
+
+unsigned Chunk::GetNeighbourMask() const
+{
+	return NeighbourMask;
+}
+
+bool Chunk::HasBakedLight() const
+{
+	return LightBaked;
+}
+
+void Chunk::Compress()
+{
+	Encode(Blocks);
+	DeleteMesh();
+	DeleteLightVolume();
+	ChunkPool::ReleaseSections(std::move(Sections));
+	Compressed = true;
+	Lighting = LIGHT_NONE;
+}
+
+void Chunk::Decompress()
+{
+	Sections = ChunkPool::AcquireSections();
+	for (unsigned x{}; x < SizeX; ++x)
 	{
-		texture.Unbind();
+		for (unsigned z{}; z < SizeZ; ++z)
+		{
+			for (const RLESpan& span : Blocks.Column(x, z))
+			{
+				if (span.Type == CubeType::EMPTY)
+				{
+					continue;
+				}
+
+				for (unsigned y = span.Begin; y < span.End; ++y)
+				{
+					Sections[y / ChunkSection::Size].SetBlock(x, y % ChunkSection::Size, z, span.Type);
+				}
+			}
+		}
+	}
+
+	// Capacity is kept for the next Compress.
+	Blocks.Clear();
+	Compressed = false;
+}
+
+bool Chunk::IsCompressed() const
+{
+	return Compressed;
+}
+
+bool Chunk::Save(const std::string& path)
+{
+	if (Compressed)
+	{
+		UnsavedEdits = !Blocks.Save(path);
+	}
+	else
+	{
+		RLEChunk blocks;
+		Encode(blocks);
+		UnsavedEdits = !blocks.Save(path);
+	}
+	return !UnsavedEdits;
+}
+
+bool Chunk::HasUnsavedEdits() const
+{
+	return UnsavedEdits;
+}
+
+CubeType Chunk::GetBlock(unsigned x, unsigned y, unsigned z) const
+{
+	if (Compressed)
+	{
+		return Blocks.TypeAt(x, y, z);
+	}
+	return Sections[y / ChunkSection::Size].GetBlock(x, y % ChunkSection::Size, z);
+}
+
+bool Chunk::IsSectionEmpty(unsigned index) const
+{
+	return Compressed || Sections[index].IsEmpty();
+}
+
+bool Chunk::IsSectionFull(unsigned index) const
+{
+	return !Compressed && Sections[index].IsFull();
+}
+
+bool Chunk::CanSeeThrough(unsigned index, Side from, Side to) const
+{
+	return Compressed || Sections[index].CanSeeThrough(from, to);
+}
+
+unsigned Chunk::GetDrawMask() const
+{
+	return DrawMask;
+}
+
+const std::array<uint16_t, Chunk::OccluderCells>& Chunk::GetOccluderHeights() const
+{
+	return OccluderHeights;
+}
+
+void Chunk::SetBlock(unsigned x, unsigned y, unsigned z, CubeType type)
+{
+	const unsigned index = y / ChunkSection::Size;
+	const unsigned localY = y % ChunkSection::Size;
+	Sections[index].SetBlock(x, localY, z, type);
+	UnsavedEdits = true;
+
+	MarkSectionDirty(index);
+	if (localY == 0 && index > 0)
+	{
+		MarkSectionDirty(index - 1);
+	}
+	if (localY == ChunkSection::Size - 1 && index + 1 < SectionCount)
+	{
+		MarkSectionDirty(index + 1);
 	}
 }
 
-void Chunk::DeleteTextures() const
+void Chunk::MarkSectionDirty(unsigned index)
 {
-	for (const Texture2D& texture : Textures)
+	if (!Compressed)
 	{
-		texture.Delete();
+		Sections[index].Dirty = true;
 	}
 }
 
-void Chunk::DeleteBuffers() const
+uint8_t Chunk::GetLight(unsigned x, unsigned y, unsigned z) const
+{
+	if (Compressed)
+	{
+		return LightEngine::FullSky;
+	}
+	return Sections[y / ChunkSection::Size].GetLight(x, y % ChunkSection::Size, z);
+}
+
+void Chunk::SetLight(unsigned x, unsigned y, unsigned z, uint8_t light)
+{
+	Sections[y / ChunkSection::Size].SetLight(x, y % ChunkSection::Size, z, light);
+}
+
+void Chunk::FillSectionLight(unsigned index, uint8_t light)
+{
+	Sections[index].FillLight(light);
+}
+
+LightStage Chunk::GetLightStage() const
+{
+	return Lighting;
+}
+
+void Chunk::SetLightStage(LightStage stage)
+{
+	Lighting = stage;
+}
+
+void Chunk::MarkSectionLightDirty(unsigned index)
+{
+	LightDirty |= 1u << index;
+}
+
+void Chunk::BakeLightChanges()
 {
-	for (const auto& entry : buffers)
+	for (unsigned sections = LightDirty; sections != 0; sections &= sections - 1)
 	{
-		entry.second.ebo.Delete();
-		entry.second.vbo.Delete();
-		entry.second.vao.Delete();
+		MarkSectionDirty(std::countr_zero(sections));
 	}
+	DeleteLightVolume();
+	LightDirty = 0;
 }
 
-void Chunk::DeleteBuffersData()
+void Chunk::UpdateLightVolume(const std::array<const Chunk*, 9>& neighbours)
 {
-	for (auto& [type, data] : BuffersData)
+	if (Compressed || Lighting == LIGHT_NONE)
+	{
+		return;
+	}
+
+	// Neighbours without light repeat the chunk's own edge instead.
+	unsigned litNeighbours = 0;
+	for (unsigned index{}; index < neighbours.size(); ++index)
+	{
+		const Chunk* neighbour = neighbours[index];
+		if (neighbour && neighbour != this && !neighbour->IsCompressed() && neighbour->GetLightStage() != LIGHT_NONE)
+		{
+			litNeighbours |= 1u << index;
+		}
+	}
+	if (LightTexture.ID == 0)
+	{
+		LightTexture = Texture3D(LightVolumeX, SizeY, LightVolumeZ, LightVolumeUnit);
+		LightDirty = AllSections;
+	}
+	else if (litNeighbours != LightNeighbours)
+	{
+		LightDirty = AllSections;
+	}
+	LightNeighbours = litNeighbours;
+	if (LightDirty == 0)
+	{
+		return;
+	}
+
+	// Where every column of the volume reads its light from.
+	struct LightColumn
+	{
+		const Chunk* source;
+		unsigned x, z;
+	};
+	std::array<LightColumn, LightVolumeX * LightVolumeZ> columns;
+	for (unsigned vz{}; vz < LightVolumeZ; ++vz)
+	{
+		for (unsigned vx{}; vx < LightVolumeX; ++vx)
+		{
+			const int x = static_cast<int>(vx) - 1;
+			const int z = static_cast<int>(vz) - 1;
+			const unsigned dx = x < 0 ? 0 : x >= static_cast<int>(SizeX) ? 2 : 1;
+			const unsigned dz = z < 0 ? 0 : z >= static_cast<int>(SizeZ) ? 2 : 1;
+			const unsigned index = dx * 3 + dz;
+			LightColumn& column = columns[vz * LightVolumeX + vx];
+			if (litNeighbours & (1u << index))
+			{
+				column = { neighbours[index], static_cast<unsigned>(x + SizeX) % SizeX, static_cast<unsigned>(z + SizeZ) % SizeZ };
+			}
+			else
+			{
+				column = { this, static_cast<unsigned>(std::clamp(x, 0, static_cast<int>(SizeX) - 1)),
+					static_cast<unsigned>(std::clamp(z, 0, static_cast<int>(SizeZ) - 1)) };
+			}
+		}
+	}
+
+	// One section high slab at a time, sky in red and block light in green, levels scaled to 0-255.
+	std::array<GLubyte, LightVolumeX * LightVolumeZ * ChunkSection::Size * 2> texels;
+	for (unsigned sections = LightDirty; sections != 0; sections &= sections - 1)
 	{
-		delete[] data.data;
+		const unsigned index = std::countr_zero(sections);
+		const unsigned bottom = index * ChunkSection::Size;
+		GLubyte* texel = texels.data();
+		for (unsigned vz{}; vz < LightVolumeZ; ++vz)
+		{
+			for (unsigned y = bottom; y < bottom + ChunkSection::Size; ++y)
+			{
+				for (unsigned vx{}; vx < LightVolumeX; ++vx)
+				{
+					const LightColumn& column = columns[vz * LightVolumeX + vx];
+					const uint8_t light = column.source->GetLight(column.x, y, column.z);
+					*texel++ = static_cast<GLubyte>(LightEngine::GetSky(light) * 17u);
+					*texel++ = static_cast<GLubyte>(LightEngine::GetBlock(light) * 17u);
+				}
+			}
+		}
+		LightTexture.Update(0, bottom, 0, LightVolumeX, ChunkSection::Size, LightVolumeZ, texels.data());
 	}
-	BuffersData.clear();
+	LightDirty = 0;
+}
+
+bool Chunk::HasLightVolume() const
+{
+	return LightTexture.ID != 0;
+}
+
+void Chunk::Pin()
+{
+	++Pins;
 }
 
-void Chunk::GenBuffers(const CubeType& type)
+void Chunk::Unpin()
 {
-	GLfloat* vertices = BuffersData.at(type).data;
-	buffers[type].vao = VAO();
-	Buffers& bfs = buffers.at(type);
-	bfs.vao.Bind();
-	bfs.vbo = VBO(vertices, BuffersData.at(type).size * sizeof(GLfloat), GL_STATIC_DRAW);
-	bfs.vao.LinkAttrib(0, 3, GL_FLOAT, sizeof(GLfloat) * 8, (void*)0);
-	bfs.vao.LinkAttrib(1, 2, GL_FLOAT, sizeof(GLfloat) * 8, (void*)(sizeof(GLfloat) * 3));
-	bfs.vao.LinkAttrib(2, 3, GL_FLOAT, sizeof(GLfloat) * 8, (void*)(sizeof(GLfloat) * 5));
-	bfs.ebo = EBO(blockTypeIndices.at(type).data(), blockTypeIndices.at(type).size() * sizeof(GLuint), GL_STATIC_DRAW);
+	--Pins;
+}
 
-	bfs.vao.Unbind();
-	bfs.vbo.Unbind();
-	bfs.ebo.Unbind();
+bool Chunk::IsPinned() const
+{
+	return Pins > 0;
 }
 
-void Chunk::GenAllBuffers()
+float* const Chunk::GenChunk()
 {
-	buffers.clear();
-	for (const auto& entry : blockTypeVertices)
+	float* const heightMap = new float[SizeX * SizeZ];
+	const float scale = 0.01f;
+	const int32_t octaves = 3;
+
+	for (unsigned x{}; x < SizeX; ++x)
 	{
-		GenBuffers(entry.first);
+		for (unsigned z{}; z < SizeZ; ++z)
+		{
+			double uniqueX = (Position.x + x) * scale;
+			double uniqueZ = (Position.z + z) * scale;
+
+			const float perlin = static_cast<float>(perlinNoise.octave2D_01(uniqueX, uniqueZ, octaves));
+			heightMap[x * SizeZ + z] = perlin * TerrainHeight;
+		}
 	}
+	return heightMap;
 }
 
-void Chunk::GenFaces()
+void Chunk::GenBlocks(float* const heightMap)
 {
 #if TIMER
-	Timer timer("GenFaces");
+	Timer timer("GenBlocks");
 #endif
 
-	for (auto& [type, vertices] : blockTypeVertices) vertices.clear();
-	for (auto& [type, indices] : blockTypeIndices) indices.clear();
-	Textures.clear();
+	// Every column is dirt, one grass block and air, so it is written as runs directly.
+	Blocks.Clear();
+	for (unsigned x{}; x < SizeX; ++x)
+	{
+		for (unsigned z{}; z < SizeZ; ++z)
+		{
+			const unsigned height = static_cast<unsigned>(std::clamp(static_cast<int>(heightMap[x * SizeZ + z]), 0, static_cast<int>(SizeY)));
+			if (height > 1)
+			{
+				Blocks.PushRun(CubeType::DIRT, height - 1);
+			}
+			if (height > 0)
+			{
+				Blocks.PushRun(CubeType::GRASS, 1);
+			}
+			Blocks.PushRun(CubeType::EMPTY, SizeY - height);
+			Blocks.EndColumn();
+		}
+	}
+	Blocks.ShrinkToFit();
+}
 
-	Textures.insert(ResourceManager::GetTexture("atlas-1"));
+std::array<uint16_t, Chunk::SizeX * Chunk::SizeZ> Chunk::GetSkyTops(const float* heightMap)
+{
+	// Same heights as GenBlocks, every block below the top is opaque.
+	std::array<uint16_t, SizeX * SizeZ> tops;
+	for (unsigned column{}; column < SizeX * SizeZ; ++column)
+	{
+		tops[column] = static_cast<uint16_t>(std::clamp(static_cast<int>(heightMap[column]), 0, static_cast<int>(SizeY)));
+	}
+	return tops;
+}
 
-	for (int x{}; x < Size_X; ++x)
+void Chunk::Encode(RLEChunk& blocks) const
+{
+	blocks.Init(SizeX, SizeY, SizeZ);
+	for (unsigned x{}; x < SizeX; ++x)
 	{
-		for (int z{}; z < Size_Z; ++z)
+		for (unsigned z{}; z < SizeZ; ++z)
 		{
-			for (int y{}; y < Size_Y; ++y)
+			for (unsigned index{}; index < SectionCount; ++index)
 			{
-				const Cube& cube = Cubes.at(x, z, y);
-				const CubeType& type = cube.Type();
-				if (type == CubeType::EMPTY)
+				const ChunkSection& section = Sections[index];
+				if (section.IsEmpty())
 				{
+					blocks.PushRun(CubeType::EMPTY, ChunkSection::Size);
 					continue;
 				}
-				
-				// Right & Left.
-				if (x == Size_X - 1 || Cubes.at(x + 1, z, y).Type() == CubeType::EMPTY)
+
+				for (unsigned y{}; y < ChunkSection::Size; ++y)
 				{
-					AddFace(type, cube, Side::RIGHT);
+					blocks.PushRun(section.GetBlock(x, y, z), 1u);
 				}
-				if (x == 0 || Cubes.at(x - 1, z, y).Type() == CubeType::EMPTY)
+			}
+			blocks.EndColumn();
+		}
+	}
+	blocks.ShrinkToFit();
+}
+
+void Chunk::DeleteLightVolume()
+{
+	if (LightTexture.ID != 0)
+	{
+		LightTexture.Delete();
+		LightTexture = Texture3D();
+	}
+	LightDirty = AllSections;
+	LightNeighbours = 0;
+}
+
+void Chunk::BindTextures() const
+{
+	for (const Texture2DArray& texture : Textures)
+	{
+		texture.Bind();
+	}
+}
+
+void Chunk::UnbindTextures() const
+{
+	for (const Texture2DArray& texture : Textures)
+	{
+		texture.Unbind();
+	}
+}
+
+const Chunk* Chunk::GetColumnChunk(int& x, int& z, const std::array<Chunk*, 4>& neighbours) const
+{
+	const int sizeX = static_cast<int>(SizeX);
+	const int sizeZ = static_cast<int>(SizeZ);
+	if (x < 0)
+	{
+		x += sizeX;
+		return neighbours[Side::LEFT];
+	}
+	if (x >= sizeX)
+	{
+		x -= sizeX;
+		return neighbours[Side::RIGHT];
+	}
+	if (z < 0)
+	{
+		z += sizeZ;
+		return neighbours[Side::BACK];
+	}
+	if (z >= sizeZ)
+	{
+		z -= sizeZ;
+		return neighbours[Side::FRONT];
+	}
+	return this;
+}
+
+CubeType Chunk::GetBlockOrNeighbour(int x, int y, int z, const std::array<Chunk*, 4>& neighbours) const
+{
+	// The world bottom is closed, the sky is open.
+	if (y < 0)
+	{
+		return CubeType::DIRT;
+	}
+	if (y >= static_cast<int>(SizeY))
+	{
+		return CubeType::EMPTY;
+	}
+
+	const Chunk* chunk = GetColumnChunk(x, z, neighbours);
+	return chunk ? chunk->GetBlock(x, y, z) : CubeType::EMPTY;
+}
+
+uint8_t Chunk::GetLightOrNeighbour(int x, int y, int z, const std::array<Chunk*, 4>& neighbours) const
+{
+	if (y < 0)
+	{
+		return 0;
+	}
+	if (y >= static_cast<int>(SizeY))
+	{
+		return LightEngine::FullSky;
+	}
+
+	// Missing and unlit neighbours are treated as open sky, like their blocks are treated as air.
+	const Chunk* chunk = GetColumnChunk(x, z, neighbours);
+	return chunk && chunk->GetLightStage() != LIGHT_NONE ? chunk->GetLight(x, y, z) : LightEngine::FullSky;
+}
+
+bool Chunk::IsSectionOccluded(unsigned index, const std::array<Chunk*, 4>& neighbours) const
+{
+	if (!Sections[index].IsFull() || index + 1 == SectionCount || !Sections[index + 1].IsFull())
+	{
+		return false;
+	}
+	if (index > 0 && !Sections[index - 1].IsFull())
+	{
+		return false;
+	}
+
+	for (const Chunk* neighbour : neighbours)
+	{
+		if (!neighbour || !neighbour->IsSectionFull(index))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void Chunk::FillPadded(PaddedSection<ChunkSection::Size>& padded, unsigned index, const std::array<Chunk*, 4>& neighbours, bool bakeLight) const
+{
+	using Padded = PaddedSection<ChunkSection::Size>;
+	constexpr unsigned Size = ChunkSection::Size;
+	const int baseY = static_cast<int>(index * Size);
+	const ChunkSection* below = index > 0 ? &Sections[index - 1] : nullptr;
+	const ChunkSection* above = index + 1 < SectionCount ? &Sections[index + 1] : nullptr;
+	if (!bakeLight)
+	{
+		padded.Light.fill(LightEngine::FullSky);
+	}
+
+	// Columns are contiguous in both layouts, inside the chunk they are copied whole.
+	for (unsigned x{}; x < Size; ++x)
+	{
+		for (unsigned z{}; z < Size; ++z)
+		{
+			CubeType* column = &padded.Blocks[Padded::Layout::Index(x + 1, z + 1, 0)];
+			const CubeType* blocks = Sections[index].GetColumn(x, z);
+			if (blocks)
+			{
+				memcpy(column + 1, blocks, Size * sizeof(CubeType));
+			}
+			else
+			{
+				std::fill_n(column + 1, Size, CubeType::EMPTY);
+			}
+
+			// The world bottom is closed, the sky is open.
+			column[0] = below ? below->GetBlock(x, Size - 1, z) : CubeType::DIRT;
+			column[Size + 1] = above ? above->GetBlock(x, 0, z) : CubeType::EMPTY;
+			if (!bakeLight)
+			{
+				continue;
+			}
+
+			uint8_t* lightColumn = &padded.Light[Padded::Layout::Index(x + 1, z + 1, 0)];
+			const uint8_t* light = Sections[index].GetLightColumn(x, z);
+			if (light)
+			{
+				memcpy(lightColumn + 1, light, Size);
+			}
+			else
+			{
+				std::fill_n(lightColumn + 1, Size, Sections[index].GetUniformLight());
+			}
+			lightColumn[0] = below ? below->GetLight(x, Size - 1, z) : 0;
+			lightColumn[Size + 1] = above ? above->GetLight(x, 0, z) : LightEngine::FullSky;
+		}
+	}
+
+	// The four sides come from the neighbours, one block past the section up and down for the
+	// corner shading. Blocks in the diagonal chunks aren't known and count as air, their light
+	// is taken from the block next to them.
+	for (unsigned y{}; y < Size + 2u; ++y)
+	{
+		const int worldY = baseY + static_cast<int>(y) - 1;
+		for (unsigned i{}; i < Size; ++i)
+		{
+			const unsigned left = Padded::Layout::Index(0, i + 1, y);
+			const unsigned right = Padded::Layout::Index(Size + 1, i + 1, y);
+			const unsigned back = Padded::Layout::Index(i + 1, 0, y);
+			const unsigned front = Padded::Layout::Index(i + 1, Size + 1, y);
+			padded.Blocks[left] = GetBlockOrNeighbour(-1, worldY, i, neighbours);
+			padded.Blocks[right] = GetBlockOrNeighbour(Size, worldY, i, neighbours);
+			padded.Blocks[back] = GetBlockOrNeighbour(i, worldY, -1, neighbours);
+			padded.Blocks[front] = GetBlockOrNeighbour(i, worldY, Size, neighbours);
+			if (!bakeLight)
+			{
+				continue;
+			}
+			padded.Light[left] = GetLightOrNeighbour(-1, worldY, i, neighbours);
+			padded.Light[right] = GetLightOrNeighbour(Size, worldY, i, neighbours);
+			padded.Light[back] = GetLightOrNeighbour(i, worldY, -1, neighbours);
+			padded.Light[front] = GetLightOrNeighbour(i, worldY, Size, neighbours);
+		}
+		for (unsigned x : { 0u, Size + 1u })
+		{
+			for (unsigned z : { 0u, Size + 1u })
+			{
+				padded.Blocks[Padded::Layout::Index(x, z, y)] = CubeType::EMPTY;
+				if (bakeLight)
 				{
-					AddFace(type, cube, Side::LEFT);
+					padded.Light[Padded::Layout::Index(x, z, y)] = padded.Light[Padded::Layout::Index(x, z == 0 ? 1 : Size, y)];
 				}
-				// Back & Front.
-				if (z == Size_Z - 1 || Cubes.at(x, z + 1, y).Type() == CubeType::EMPTY)
+			}
+		}
+	}
+}
+
+void Chunk::FillPaddedPerBlock(PaddedSection<ChunkSection::Size>& padded, unsigned index, const std::array<Chunk*, 4>& neighbours, bool bakeLight) const
+{
+	using Padded = PaddedSection<ChunkSection::Size>;
+	constexpr int Size = static_cast<int>(ChunkSection::Size);
+	const int baseY = static_cast<int>(index) * Size;
+	for (int x = -1; x <= Size; ++x)
+	{
+		for (int z = -1; z <= Size; ++z)
+		{
+			// Diagonal chunks aren't known, as in FillPadded.
+			const bool corner = (x < 0 || x == Size) && (z < 0 || z == Size);
+			for (int y = -1; y <= Size; ++y)
+			{
+				const unsigned cell = Padded::Layout::Index(x + 1, z + 1, y + 1);
+				padded.Blocks[cell] = corner ? CubeType::EMPTY : GetBlockOrNeighbour(x, baseY + y, z, neighbours);
+				if (!bakeLight)
 				{
-					AddFace(type, cube, Side::FRONT);
+					padded.Light[cell] = LightEngine::FullSky;
 				}
-				if (z == 0 || Cubes.at(x, z - 1, y).Type() == CubeType::EMPTY)
+				else if (!corner)
 				{
-					AddFace(type, cube, Side::BACK);
+					padded.Light[cell] = GetLightOrNeighbour(x, baseY + y, z, neighbours);
 				}
-				// Top & Bottom.
-				if (y == Size_Y - 1 || Cubes.at(x, z, y + 1).Type() == CubeType::EMPTY)
+				else
 				{
-					AddFace(type, cube, Side::TOP);
+					padded.Light[cell] = GetLightOrNeighbour(x, baseY + y, std::clamp(z, 0, Size - 1), neighbours);
 				}
-				if (0)
+			}
+		}
+	}
+}
+
+void Chunk::UpdateOccluders()
+{
+	constexpr unsigned cellsZ = SizeZ / OccluderCell;
+	for (unsigned cell{}; cell < OccluderCells; ++cell)
+	{
+		// Every column only needs scanning up to the lowest one found so far.
+		unsigned height = SizeY;
+		const unsigned baseX = cell / cellsZ * OccluderCell;
+		const unsigned baseZ = cell % cellsZ * OccluderCell;
+		for (unsigned x = baseX; x < baseX + OccluderCell && height > 0; ++x)
+		{
+			for (unsigned z = baseZ; z < baseZ + OccluderCell && height > 0; ++z)
+			{
+				unsigned y = 0;
+				for (unsigned index{}; index < SectionCount && y < height; ++index)
 				{
-					if (y == 0 || Cubes.at(x, z, y - 1).Type() == CubeType::EMPTY)
+					const CubeType* column = Sections[index].GetColumn(x, z);
+					if (!column)
+					{
+						break;
+					}
+					unsigned local = 0;
+					while (local < ChunkSection::Size && y < height && BlockRegistry::IsOpaque(column[local]))
+					{
+						++local;
+						++y;
+					}
+					if (local < ChunkSection::Size)
 					{
-						AddFace(type, cube, Side::BOTTOM);
+						break;
 					}
 				}
+				height = std::min(height, y);
+			}
+		}
+		PendingOccluderHeights[cell] = static_cast<uint16_t>(height);
+	}
+}
+
+// Offsets from the block in front of a face to the blocks around each of its corners, the two
+// along the face's edges and the diagonal one. Corners are in the order of the cube vertices.
+using CornerOffsets = std::array<std::array<std::array<int, 3>, 4>, 6>;
+
+static constexpr CornerOffsets GetCornerOffsets(unsigned stepX, unsigned stepY, unsigned stepZ)
+{
+	// Per Side the two axes along the face and the corner signs on them, see TextureData.
+	constexpr unsigned axes[6][2] = { { 0, 1 }, { 0, 1 }, { 2, 1 }, { 2, 1 }, { 0, 2 }, { 0, 2 } };
+	constexpr int signs[6][4][2] = {
+		{ { -1, 1 }, { 1, 1 }, { 1, -1 }, { -1, -1 } }, // FRONT
+		{ { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } }, // BACK
+		{ { -1, 1 }, { 1, 1 }, { 1, -1 }, { -1, -1 } }, // LEFT
+		{ { 1, 1 }, { -1, 1 }, { -1, -1 }, { 1, -1 } }, // RIGHT
+		{ { -1, 1 }, { 1, 1 }, { 1, -1 }, { -1, -1 } }, // BOTTOM
+		{ { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, 1 } }, // TOP
+	};
+	const int steps[3] = { static_cast<int>(stepX), static_cast<int>(stepY), static_cast<int>(stepZ) };
+
+	CornerOffsets offsets{};
+	for (unsigned side{}; side < 6; ++side)
+	{
+		for (unsigned corner{}; corner < 4; ++corner)
+		{
+			const int first = signs[side][corner][0] * steps[axes[side][0]];
+			const int second = signs[side][corner][1] * steps[axes[side][1]];
+			offsets[side][corner] = { first, second, first + second };
+		}
+	}
+	return offsets;
+}
+
+// Occlusion is how many of the blocks around every corner of a face are opaque, 2 bits per corner.
+// A corner between two opaque blocks is fully shadowed whatever the diagonal one is.
+// Light is the average of the open blocks around the corner that light can reach it through,
+// sky and block light scaled to a byte each, 16 bits per corner.
+template <size_t Volume>
+static void ShadeCorners(const std::array<CubeType, Volume>& blocks, const std::array<uint8_t, Volume>& light,
+	unsigned outside, Side side, const CornerOffsets& offsets, unsigned& occlusion, uint64_t& cornerLight)
+{
+	occlusion = 0;
+	cornerLight = 0;
+	for (unsigned corner{}; corner < 4; ++corner)
+	{
+		const std::array<int, 3>& around = offsets[side][corner];
+		const unsigned first = BlockRegistry::IsOpaque(blocks[outside + around[0]]);
+		const unsigned second = BlockRegistry::IsOpaque(blocks[outside + around[1]]);
+		const unsigned diagonal = BlockRegistry::IsOpaque(blocks[outside + around[2]]);
+		const unsigned level = first && second ? 3u : first + second + diagonal;
+		occlusion |= level << (corner * 2);
+
+		unsigned sky = LightEngine::GetSky(light[outside]);
+		unsigned block = LightEngine::GetBlock(light[outside]);
+		unsigned count = 1;
+		const auto add = [&](bool open, unsigned cell) {
+			if (open)
+			{
+				sky += LightEngine::GetSky(light[cell]);
+				block += LightEngine::GetBlock(light[cell]);
+				++count;
+			}
+			};
+		add(!first, outside + around[0]);
+		add(!second, outside + around[1]);
+		add(!diagonal && !(first && second), outside + around[2]);
+		const uint64_t value = (sky * 17u / count) | (block * 17u / count) << 8;
+		cornerLight |= value << (corner * 16);
+	}
+}
+
+template <unsigned Size, typename BlockSource>
+void Chunk::FillPadded(PaddedSection<Size>& padded, unsigned index, const BlockSource& blockAt)
+{
+	using Padded = PaddedSection<Size>;
+	const int baseY = static_cast<int>(index * Size);
+	for (unsigned x{}; x < Size + 2u; ++x)
+	{
+		for (unsigned z{}; z < Size + 2u; ++z)
+		{
+			for (unsigned y{}; y < Size + 2u; ++y)
+			{
+				padded.Blocks[Padded::Layout::Index(x, z, y)] = blockAt(static_cast<int>(x) - 1, baseY + static_cast<int>(y) - 1, static_cast<int>(z) - 1);
 			}
 		}
 	}
+	// Distant terrain is seen from outside, it is drawn in full daylight.
+	padded.Light.fill(LightEngine::FullSky);
 }
 
-void Chunk::AddFace(const CubeType& type, const Cube& cube, const Side& side)
+template <unsigned Size, typename BlockSource>
+void Chunk::GenLodFaces(ChunkSection& section, unsigned index, const BlockSource& blockAt)
 {
-	const std::vector<Vertex>& vertices = cube.GetVerticesSide(side);
-	AddVertices(type, vertices);
-	AddIndices(type, 1);
+	thread_local PaddedSection<Size> padded;
+	FillPadded(padded, index, blockAt);
+	GenFaces(section, padded, index);
+}
+
+template <unsigned Size>
+void Chunk::GenFaces(ChunkSection& section, const PaddedSection<Size>& padded, unsigned index)
+{
+	using Padded = PaddedSection<Size>;
+	constexpr unsigned scale = ChunkSection::Size / Size;
+	constexpr float size = static_cast<float>(scale);
+	constexpr float center = (size - 1.0f) * 0.5f;
+	const unsigned baseY = index * Size;
+	static constexpr CornerOffsets cornerOffsets = GetCornerOffsets(Padded::StepX, Padded::StepY, Padded::StepZ);
+
+	for (unsigned x{}; x < Size; ++x)
+	{
+		for (unsigned z{}; z < Size; ++z)
+		{
+			unsigned block = Padded::Layout::Index(x + 1, z + 1, 1);
+			for (unsigned y{}; y < Size; ++y, block += Padded::StepY)
+			{
+				const CubeType type = padded.Blocks[block];
+				if (!BlockRegistry::IsVisible(type))
+				{
+					continue;
+				}
+
+				const glm::vec3 offset(x * size + center, (baseY + y) * size + center, z * size + center);
+
+				const auto addFace = [&](unsigned outside, Side side) {
+					if (!BlockRegistry::IsOpaque(padded.Blocks[outside]))
+					{
+						unsigned occlusion;
+						uint64_t light;
+						ShadeCorners(padded.Blocks, padded.Light, outside, side, cornerOffsets, occlusion, light);
+						section.AddFace(type, offset, size, side, occlusion, light);
+					}
+					};
+				// Right & Left.
+				addFace(block + Padded::StepX, Side::RIGHT);
+				addFace(block - Padded::StepX, Side::LEFT);
+				// Back & Front.
+				addFace(block + Padded::StepZ, Side::FRONT);
+				addFace(block - Padded::StepZ, Side::BACK);
+				// Top & Bottom.
+				addFace(block + Padded::StepY, Side::TOP);
+				addFace(block - Padded::StepY, Side::BOTTOM);
+			}
+		}
+	}
 }
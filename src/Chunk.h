@@ -2,86 +2,218 @@
 
 #include "glm/glm.hpp"
 #include <vector>
-#include "glObjects/VAO.h"
-#include "glObjects/VBO.h"
-#include "glObjects/EBO.h"
+#include <array>
+#include <memory>
+#include <atomic>
+#include <bit>
 #include "Vertex.h"
 #include "Cube.h"
 #include "PerlinNoise/PerlinNoise.hpp"
-#include "Array3D.h"
+#include "RLEChunk.h"
+#include "ChunkSection.h"
+#include "glObjects/Texture3D.h"
 #include <unordered_set>
 
-struct Buffers
+// How far a chunk's light is, see LightEngine.
+enum LightStage : uint8_t
 {
-	VAO vao;
-	VBO vbo;
-	EBO ebo;
-};
-
-struct BufferData
-{
-	BufferData(GLfloat* dataPointer, const unsigned dataSize)
-		: data(dataPointer), size(dataSize)
-	{
-	}
-
-	GLfloat* data;
-	const unsigned size;
+	LIGHT_NONE, // No light, the sections hold none.
+	LIGHT_LOCAL, // Lit on its own, nothing has come in from the neighbours.
+	LIGHT_LINKED, // Light has flowed between it and every neighbour that was lit at the time.
 };
 
 class Chunk
 {
 public:
-	Chunk(const glm::vec2& position, unsigned size = 16u);
+	static constexpr unsigned SectionCount = 16u;
+	static constexpr unsigned SizeX = 16u;
+	static constexpr unsigned SizeY = SectionCount * ChunkSection::Size;
+	static constexpr unsigned SizeZ = 16u;
+	static constexpr unsigned AllSections = (1u << SectionCount) - 1;
+	// Occluders are boxes over OccluderCell x OccluderCell columns.
+	static constexpr unsigned OccluderCell = 4u;
+	static constexpr unsigned OccluderCells = (SizeX / OccluderCell) * (SizeZ / OccluderCell);
+	// The light volume holds the chunk's light plus one column of its neighbours' on every side.
+	static constexpr unsigned LightVolumeX = SizeX + 2u;
+	static constexpr unsigned LightVolumeZ = SizeZ + 2u;
+	static constexpr int LightVolumeUnit = 1;
+
+	Chunk(const glm::vec2& position);
 	~Chunk();
 
-	void Render(const ShaderProgram& shader, const Camera& camera, const glm::mat4& proj);
+	// Sections is a mask of the section indices to draw. With cullSides the faces pointing
+	// away from the camera are skipped per Side, before the GPU ever sees them. Given the shader's
+	// useLightVolume location, full detail meshes read their light from the light volume instead of
+	// their vertices, the caller sets the lightVolume sampler to LightVolumeUnit once per pass.
+	void Render(const ShaderProgram& shader, const Camera& camera, const glm::mat4& proj, unsigned sections = AllSections,
+		bool cullSides = true, GLint useLightVolume = -1);
 	void Delete();
 
+	// Recycling through the ChunkPool. Clear hands the sections back, Reset readies the chunk for a new key.
+	void Clear();
+	void Reset(const glm::vec2& position);
+
 	std::pair<int, int> getKey() const;
-	void GenerateData();
+	// Blocks saved by an earlier visit are loaded from savePath, otherwise they are generated.
+	void GenerateData(const std::string& savePath);
+	// Neighbours are indexed by Side (FRONT, BACK, LEFT, RIGHT), missing ones count as air.
+	// Without bakeLight full detail meshes are built in full sky, for drawing with the light volume.
+	// perBlockLookup reads every padded block through the neighbour lookups instead of copying
+	// columns, the old way, for World::BenchmarkMeshing to compare against.
+	void GenerateMesh(unsigned lod, const std::array<Chunk*, 4>& neighbours, bool bakeLight = true, bool perBlockLookup = false);
 	void GenerateOpenGLData();
 
+	// Drops CPU and GPU mesh data of every section.
+	void DeleteMesh();
+	bool HasMesh() const;
+	void MarkDirty();
+	bool IsDirty() const;
+
+	// Level of detail of the last generated mesh, blocks are 2^lod wide.
+	unsigned GetLod() const;
+	// Sides whose neighbour blocks were used for face culling by the last mesh.
+	unsigned GetNeighbourMask() const;
+	// Whether the last full detail mesh holds the light, see GenerateMesh.
+	bool HasBakedLight() const;
+
+	// Cold storage, only the RLE blocks are kept. GL thread, the chunk must not be pinned.
+	void Compress();
+	void Decompress();
+	bool IsCompressed() const;
+	// Edits since the blocks were generated or loaded go to disk as the RLE blocks. GL thread,
+	// the chunk must not be pinned.
+	bool Save(const std::string& path);
+	bool HasUnsavedEdits() const;
+
+	// Chunk-local coordinates, safe from workers while the chunk is pinned.
+	CubeType GetBlock(unsigned x, unsigned y, unsigned z) const;
+	bool IsSectionEmpty(unsigned index) const;
+	bool IsSectionFull(unsigned index) const;
+	bool CanSeeThrough(unsigned index, Side from, Side to) const;
+	// Sections with at least one face in the uploaded mesh.
+	unsigned GetDrawMask() const;
+	// Blocks from the world bottom up that are opaque in every column of the cell, cells are x-major.
+	const std::array<uint16_t, OccluderCells>& GetOccluderHeights() const;
+
+	// GL thread only, the chunk must be decompressed, idle and not pinned.
+	// Marks the edited section and the sections sharing the block's faces dirty.
+	void SetBlock(unsigned x, unsigned y, unsigned z, CubeType type);
+	void MarkSectionDirty(unsigned index);
+
+	// Light, sky in the high 4 bits and block light in the low ones. Reads follow the GetBlock rules,
+	// compressed chunks read as open sky. Writes are for the LightEngine task owning the chunk.
+	uint8_t GetLight(unsigned x, unsigned y, unsigned z) const;
+	void SetLight(unsigned x, unsigned y, unsigned z, uint8_t light);
+	void FillSectionLight(unsigned index, uint8_t light);
+	// Reset to LIGHT_NONE whenever the sections go away.
+	LightStage GetLightStage() const;
+	void SetLightStage(LightStage stage);
+	// Sections whose light changed since it last reached the GPU.
+	void MarkSectionLightDirty(unsigned index);
+	// Light changes go into the meshes instead, the changed sections are marked dirty and the
+	// light volume is dropped so it is rebuilt whole if it is used again.
+	void BakeLightChanges();
+	// GL thread, none of the chunks may be owned by a light task. Uploads the changed sections to
+	// the light volume, all of them when it is new or a neighbour got lit or went away since.
+	// Neighbours are indexed like a LightNeighbourhood, (dx + 1) * 3 + (dz + 1), the centre is unused.
+	void UpdateLightVolume(const std::array<const Chunk*, 9>& neighbours);
+	bool HasLightVolume() const;
+
+	// Chunks used as neighbours by a running mesh task are pinned, pinned chunks are not compressed or unloaded.
+	void Pin();
+	void Unpin();
+	bool IsPinned() const;
+
+public:
+	// Set by World while the chunk is in the hands of a worker thread.
+	bool MeshQueued = false;
+	// Set by World while a light task owns the chunk, as the centre or as a neighbour.
+	bool LightQueued = false;
+
 private:
 	float* const GenChunk();
 	void GenBlocks(float* const heightMap);
-	void GenBuffersData();
-	void GenBuffers(const CubeType& type);
-	void GenAllBuffers();
-	void GenFaces();
-	void AddFace(const CubeType& type, const Cube& cube, const Side& side);
-
-	void AddVertices(const CubeType& type, const std::vector<Vertex>& vertices);
-	void AddIndices(const CubeType& type, unsigned faces = 6);
+	// First open y of every column, x-major, the sky light comes down to there.
+	static std::array<uint16_t, SizeX * SizeZ> GetSkyTops(const float* heightMap);
+	void Encode(RLEChunk& blocks) const;
+
+	// A section's blocks with a one block border, so every face test is a constant offset.
+	// Indexed as (x, z, y) like the sections, y runs fastest.
+	template <unsigned Size>
+	struct PaddedSection
+	{
+		static constexpr unsigned Width = std::bit_ceil(Size + 2u);
+		using Layout = FixedArray3D<CubeType, Width, Width, Width>;
+		static constexpr unsigned StepX = Layout::Policy::StepX;
+		static constexpr unsigned StepZ = Layout::Policy::StepY;
+		static constexpr unsigned StepY = Layout::Policy::StepZ;
+
+		std::array<CubeType, Layout::Volume> Blocks;
+		std::array<uint8_t, Layout::Volume> Light;
+	};
+
+	void FillPadded(PaddedSection<ChunkSection::Size>& padded, unsigned index, const std::array<Chunk*, 4>& neighbours, bool bakeLight) const;
+	void FillPaddedPerBlock(PaddedSection<ChunkSection::Size>& padded, unsigned index, const std::array<Chunk*, 4>& neighbours, bool bakeLight) const;
+	template <unsigned Size, typename BlockSource>
+	static void FillPadded(PaddedSection<Size>& padded, unsigned index, const BlockSource& blockAt);
+	template <unsigned Size, typename BlockSource>
+	static void GenLodFaces(ChunkSection& section, unsigned index, const BlockSource& blockAt);
+	template <unsigned Size>
+	static void GenFaces(ChunkSection& section, const PaddedSection<Size>& padded, unsigned index);
+	// Chunk holding the column, this or a neighbour, x and z are made local to it. Null for missing neighbours.
+	const Chunk* GetColumnChunk(int& x, int& z, const std::array<Chunk*, 4>& neighbours) const;
+	CubeType GetBlockOrNeighbour(int x, int y, int z, const std::array<Chunk*, 4>& neighbours) const;
+	uint8_t GetLightOrNeighbour(int x, int y, int z, const std::array<Chunk*, 4>& neighbours) const;
+	bool IsSectionOccluded(unsigned index, const std::array<Chunk*, 4>& neighbours) const;
+	void UpdateOccluders();
+
+	void DeleteLightVolume();
+
+	// Rebuilds the multi-draw arguments from the section ranges.
+	void UpdateDrawRanges();
 
 	void BindTextures() const;
 	void UnbindTextures() const;
-	void DeleteTextures() const;
-
-	void DeleteBuffers() const;
-	void DeleteBuffersData();
 
 private:
 	// Positioning.
 	glm::vec3 Position;
 	glm::vec2 ChunkPosition;
 
-	unsigned Size_X = 16u;
-	unsigned Size_Y = 32;
-	unsigned Size_Z = 16u;
-
-	// Naive Meshing.
-	Array3D<Cube> Cubes;
-	std::unordered_set<Texture2D, Texture2D::Hash> Textures;
-
-	// Cubes Data.
-	std::unordered_map<CubeType, std::vector<Vertex>> blockTypeVertices;
-	std::unordered_map<CubeType, std::vector<GLuint>> blockTypeIndices;
-	std::unordered_map<CubeType, Material> blockTypeMaterial;
-
-	// Buffers.
-	std::unordered_map<CubeType, Buffers> buffers;
-	std::unordered_map<CubeType, BufferData> BuffersData;
+	float TerrainHeight = 32.0f;
+
+	// Voxel Data.
+	std::unique_ptr<ChunkSection[]> Sections;
+	RLEChunk Blocks;
+	bool Compressed = true;
+	bool UnsavedEdits = false;
+	std::atomic<int> Pins{ 0 };
+	LightStage Lighting = LIGHT_NONE;
+
+	// Light State.
+	Texture3D LightTexture;
+	unsigned LightDirty = AllSections;
+	unsigned LightNeighbours = 0; // Neighbours whose light is in the volume's border.
+
+	// Mesh State.
+	bool Meshed = false;
+	unsigned Lod = 0;
+	unsigned NeighbourMask = 0;
+	bool LightBaked = true;
+
+	// One buffer set for every section and block type, drawn with a single multi-draw.
+	Buffers Mesh;
+	std::array<MeshRange, SectionCount> DrawRanges{};
+	std::array<uint8_t, SectionCount> DrawSections{};
+	unsigned DrawCount = 0;
+	unsigned DrawMask = 0; // Sections with at least one face.
+
+	// Solid base of the terrain, built with the mesh and published with it.
+	std::array<uint16_t, OccluderCells> OccluderHeights{};
+	std::array<uint16_t, OccluderCells> PendingOccluderHeights{};
+
+	std::unordered_set<Texture2DArray, Texture2DArray::Hash> Textures;
+	Material material;
 
 	// Perlin Noise.
 	const siv::PerlinNoise::seed_type seed = 1234567890u;
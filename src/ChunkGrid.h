@@ -0,0 +1,82 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <utility>
+#include <vector>
+
+class Chunk;
+
+struct ChunkSlot
+{
+	std::pair<int, int> Key{ 0, 0 };
+	Chunk* chunk = nullptr;
+	bool Waiting = false; // Generation task queued or running.
+	bool MeshRequested = false;
+	bool Edited = false;
+	bool LightRequested = false;
+	std::vector<glm::ivec3> LightEdits{}; // Chunk-local blocks changed since the last light task.
+
+	bool IsFree() const
+	{
+		return !chunk && !Waiting;
+	}
+};
+
+// Toroidal grid of chunk slots, key (x, z) lives in slot (x mod N, z mod N).
+// Keys closer than N to each other never share a slot, so as long as everything
+// loaded stays within Radius of the player lookups are plain array indexing and
+// moving the player needs no rehashing, slots are simply reused.
+class ChunkGrid
+{
+public:
+	void Init(int radius)
+	{
+		Radius = radius;
+		Width = 2 * radius + 1;
+		Slots.assign(static_cast<size_t>(Width) * Width, ChunkSlot{});
+	}
+
+	// Slot the key maps to, which may still be owned by another key.
+	ChunkSlot& At(const std::pair<int, int>& key)
+	{
+		return Slots[Index(key)];
+	}
+
+	const ChunkSlot& At(const std::pair<int, int>& key) const
+	{
+		return Slots[Index(key)];
+	}
+
+	// Slot owned by the key, or nullptr.
+	ChunkSlot* Find(const std::pair<int, int>& key)
+	{
+		ChunkSlot& slot = At(key);
+		return !slot.IsFree() && slot.Key == key ? &slot : nullptr;
+	}
+
+	Chunk* Get(const std::pair<int, int>& key) const
+	{
+		const ChunkSlot& slot = At(key);
+		return slot.Key == key ? slot.chunk : nullptr;
+	}
+
+	// Index into GetSlots of the slot the key maps to.
+	size_t GetSlotIndex(const std::pair<int, int>& key) const { return Index(key); }
+
+	std::vector<ChunkSlot>& GetSlots() { return Slots; }
+	const std::vector<ChunkSlot>& GetSlots() const { return Slots; }
+	int GetRadius() const { return Radius; }
+
+private:
+	size_t Index(const std::pair<int, int>& key) const
+	{
+		const int x = ((key.first % Width) + Width) % Width;
+		const int z = ((key.second % Width) + Width) % Width;
+		return static_cast<size_t>(z) * Width + x;
+	}
+
+private:
+	std::vector<ChunkSlot> Slots;
+	int Radius = 0;
+	int Width = 1;
+};
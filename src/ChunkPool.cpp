@@ -0,0 +1,171 @@
+#include "ChunkPool.h"
+#include "Chunk.h"
+
+std::mutex ChunkPool::Mutex;
+std::vector<Chunk*> ChunkPool::FreeChunks;
+std::vector<std::unique_ptr<ChunkSection[]>> ChunkPool::FreeSections;
+std::vector<CubeType*> ChunkPool::FreeStorage;
+std::vector<uint8_t*> ChunkPool::FreeLight;
+
+Chunk* ChunkPool::AcquireChunk(const glm::vec2& position)
+{
+	Chunk* chunk = nullptr;
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (!FreeChunks.empty())
+		{
+			chunk = FreeChunks.back();
+			FreeChunks.pop_back();
+		}
+	}
+
+	if (!chunk)
+	{
+		return new Chunk(position);
+	}
+	chunk->Reset(position);
+	return chunk;
+}
+
+void ChunkPool::ReleaseChunk(Chunk* chunk)
+{
+	chunk->Delete();
+	chunk->Clear();
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (FreeChunks.size() < MaxChunks)
+		{
+			FreeChunks.emplace_back(chunk);
+			return;
+		}
+	}
+	delete chunk;
+}
+
+std::unique_ptr<ChunkSection[]> ChunkPool::AcquireSections()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (!FreeSections.empty())
+		{
+			std::unique_ptr<ChunkSection[]> sections = std::move(FreeSections.back());
+			FreeSections.pop_back();
+			return sections;
+		}
+	}
+	return std::make_unique<ChunkSection[]>(Chunk::SectionCount);
+}
+
+void ChunkPool::ReleaseSections(std::unique_ptr<ChunkSection[]> sections)
+{
+	if (!sections)
+	{
+		return;
+	}
+
+	for (unsigned index{}; index < Chunk::SectionCount; ++index)
+	{
+		sections[index].Clear();
+	}
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (FreeSections.size() < MaxSections)
+	{
+		FreeSections.emplace_back(std::move(sections));
+	}
+}
+
+CubeType* ChunkPool::AcquireStorage()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (!FreeStorage.empty())
+		{
+			CubeType* const storage = FreeStorage.back();
+			FreeStorage.pop_back();
+			return storage;
+		}
+	}
+	return new CubeType[ChunkSection::Storage::Volume];
+}
+
+void ChunkPool::ReleaseStorage(CubeType* storage)
+{
+	if (!storage)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (FreeStorage.size() < MaxStorage)
+		{
+			FreeStorage.emplace_back(storage);
+			return;
+		}
+	}
+	delete[] storage;
+}
+
+uint8_t* ChunkPool::AcquireLight()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (!FreeLight.empty())
+		{
+			uint8_t* const light = FreeLight.back();
+			FreeLight.pop_back();
+			return light;
+		}
+	}
+	return new uint8_t[ChunkSection::LightStorage::Volume];
+}
+
+void ChunkPool::ReleaseLight(uint8_t* light)
+{
+	if (!light)
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (FreeLight.size() < MaxLight)
+		{
+			FreeLight.emplace_back(light);
+			return;
+		}
+	}
+	delete[] light;
+}
+
+void ChunkPool::Clear()
+{
+	std::vector<Chunk*> chunks;
+	std::vector<std::unique_ptr<ChunkSection[]>> sections;
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		chunks.swap(FreeChunks);
+		sections.swap(FreeSections);
+	}
+
+	// Sections hand their storage back while being destroyed, so storage goes last.
+	for (Chunk* chunk : chunks)
+	{
+		delete chunk;
+	}
+	sections.clear();
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	for (CubeType* storage : FreeStorage)
+	{
+		delete[] storage;
+	}
+	FreeStorage.clear();
+	for (uint8_t* light : FreeLight)
+	{
+		delete[] light;
+	}
+	FreeLight.clear();
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include "TextureData.h"
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Chunk;
+class ChunkSection;
+
+// Recycles chunks, their section arrays and section block and light storage, so streaming
+// keeps reusing the same memory instead of allocating a chunk's worth every load.
+// Every pool is bounded, anything beyond the limit is freed for real.
+class ChunkPool
+{
+public:
+	// Any thread.
+	static Chunk* AcquireChunk(const glm::vec2& position);
+	// GL thread, the chunk must not be pinned or queued. Drops its mesh and blocks.
+	static void ReleaseChunk(Chunk* chunk);
+
+	// Any thread. Sections come back empty and without a mesh.
+	static std::unique_ptr<ChunkSection[]> AcquireSections();
+	static void ReleaseSections(std::unique_ptr<ChunkSection[]> sections);
+
+	// Any thread, storage for the blocks of one section, contents undefined.
+	static CubeType* AcquireStorage();
+	static void ReleaseStorage(CubeType* storage);
+
+	// Any thread, storage for the light of one section, contents undefined.
+	static uint8_t* AcquireLight();
+	static void ReleaseLight(uint8_t* light);
+
+	static void Clear();
+
+private:
+	ChunkPool() {}
+
+private:
+	static constexpr size_t MaxChunks = 64u;
+	static constexpr size_t MaxSections = 64u;
+	static constexpr size_t MaxStorage = 1024u;
+	static constexpr size_t MaxLight = 1024u;
+
+	static std::mutex Mutex;
+	static std::vector<Chunk*> FreeChunks;
+	static std::vector<std::unique_ptr<ChunkSection[]>> FreeSections;
+	static std::vector<CubeType*> FreeStorage;
+	static std::vector<uint8_t*> FreeLight;
+};
@@ -0,0 +1,318 @@
+#include "ChunkSection.h"
+#include "ChunkPool.h"
+#include <algorithm>
+#include <array>
+
+// Faces of the section being meshed on this thread, one list per Side. They are only
+// expanded into vertices once every face is in, straight into their final place.
+struct StagedFace
+{
+	glm::vec3 Offset;
+	float Scale;
+	CubeType Type;
+	uint8_t Occlusion;
+	uint64_t Light;
+};
+static thread_local std::array<std::vector<StagedFace>, 6> SideFaces;
+
+// Vertex alpha for every occlusion level, read by the shader as a brightness.
+static constexpr std::array<GLuint, 4> OcclusionBrightness = { 255u, 196u, 150u, 110u };
+
+ChunkSection::ChunkSection()
+{
+}
+
+ChunkSection::~ChunkSection()
+{
+	ReleaseMesh();
+	ChunkPool::ReleaseStorage(Blocks.Release());
+	ChunkPool::ReleaseLight(Light.Release());
+}
+
+CubeType ChunkSection::GetBlock(unsigned x, unsigned y, unsigned z) const
+{
+	if (SolidCount == 0)
+	{
+		return CubeType::EMPTY;
+	}
+	return Blocks.at(x, z, y);
+}
+
+void ChunkSection::SetBlock(unsigned x, unsigned y, unsigned z, CubeType type)
+{
+	if (!Blocks.IsAllocated())
+	{
+		if (type == CubeType::EMPTY)
+		{
+			return;
+		}
+
+		Blocks.Adopt(ChunkPool::AcquireStorage());
+		std::fill_n(Blocks.data(), Storage::Volume, CubeType::EMPTY);
+	}
+
+	CubeType& block = Blocks.at(x, z, y);
+	if (block != CubeType::EMPTY)
+	{
+		--SolidCount;
+	}
+	if (type != CubeType::EMPTY)
+	{
+		++SolidCount;
+	}
+	OpaqueCount += BlockRegistry::IsOpaque(type);
+	OpaqueCount -= BlockRegistry::IsOpaque(block);
+	block = type;
+
+	if (SolidCount == 0)
+	{
+		ChunkPool::ReleaseStorage(Blocks.Release());
+	}
+}
+
+const CubeType* ChunkSection::GetColumn(unsigned x, unsigned z) const
+{
+	return Blocks.IsAllocated() ? &Blocks.at(x, z, 0) : nullptr;
+}
+
+uint8_t ChunkSection::GetLight(unsigned x, unsigned y, unsigned z) const
+{
+	return Light.IsAllocated() ? Light.at(x, z, y) : UniformLight;
+}
+
+void ChunkSection::SetLight(unsigned x, unsigned y, unsigned z, uint8_t light)
+{
+	if (!Light.IsAllocated())
+	{
+		if (light == UniformLight)
+		{
+			return;
+		}
+
+		Light.Adopt(ChunkPool::AcquireLight());
+		std::fill_n(Light.data(), LightStorage::Volume, UniformLight);
+	}
+	Light.at(x, z, y) = light;
+}
+
+void ChunkSection::FillLight(uint8_t light)
+{
+	ChunkPool::ReleaseLight(Light.Release());
+	UniformLight = light;
+}
+
+const uint8_t* ChunkSection::GetLightColumn(unsigned x, unsigned z) const
+{
+	return Light.IsAllocated() ? &Light.at(x, z, 0) : nullptr;
+}
+
+uint8_t ChunkSection::GetUniformLight() const
+{
+	return UniformLight;
+}
+
+bool ChunkSection::IsEmpty() const
+{
+	return SolidCount == 0;
+}
+
+bool ChunkSection::IsFull() const
+{
+	return OpaqueCount == Size * Size * Size;
+}
+
+void ChunkSection::Clear()
+{
+	DeleteMesh();
+	ChunkPool::ReleaseStorage(Blocks.Release());
+	FillLight(0);
+	SolidCount = 0;
+	OpaqueCount = 0;
+	Dirty = true;
+}
+
+void ChunkSection::BeginMesh()
+{
+	ReleaseMesh();
+	PendingSideCounts.fill(0);
+	PendingVisibility = AllVisible;
+	for (std::vector<StagedFace>& faces : SideFaces)
+	{
+		faces.clear();
+	}
+}
+
+void ChunkSection::UpdateVisibility()
+{
+	if (OpaqueCount == 0)
+	{
+		PendingVisibility = AllVisible;
+		return;
+	}
+	if (IsFull())
+	{
+		PendingVisibility = 0;
+		return;
+	}
+
+	// Only cells on the border can connect faces, so floods start there and pockets inside are never visited.
+	thread_local std::array<uint64_t, Storage::Volume / 64> visited;
+	thread_local std::vector<uint16_t> queue;
+	visited.fill(0);
+	queue.reserve(Storage::Volume);
+
+	constexpr unsigned Last = Size - 1;
+	const auto isOpen = [this](unsigned index) {
+		return !BlockRegistry::IsOpaque(Blocks.data()[index]);
+		};
+	const auto visit = [](unsigned index) {
+		const uint64_t bit = 1ull << (index & 63u);
+		const bool seen = visited[index >> 6] & bit;
+		visited[index >> 6] |= bit;
+		return !seen;
+		};
+
+	uint64_t visibility = 0;
+	for (unsigned x{}; x < Size; ++x)
+	{
+		for (unsigned z{}; z < Size; ++z)
+		{
+			const bool sideColumn = x == 0 || x == Last || z == 0 || z == Last;
+			for (unsigned y{}; y < Size; y += sideColumn ? 1u : Last)
+			{
+				const unsigned start = Storage::Index(x, z, y);
+				if (!isOpen(start) || !visit(start))
+				{
+					continue;
+				}
+
+				unsigned faces = 0;
+				queue.clear();
+				queue.push_back(static_cast<uint16_t>(start));
+				for (size_t next{}; next < queue.size(); ++next)
+				{
+					const unsigned index = queue[next];
+					const unsigned cx = index / Storage::Policy::StepX;
+					const unsigned cz = index / Storage::Policy::StepY % Size;
+					const unsigned cy = index % Size;
+					faces |= (cx == 0) << Side::LEFT | (cx == Last) << Side::RIGHT
+						| (cz == 0) << Side::BACK | (cz == Last) << Side::FRONT
+						| (cy == 0) << Side::BOTTOM | (cy == Last) << Side::TOP;
+
+					const auto spread = [&](bool inside, unsigned neighbour) {
+						if (inside && isOpen(neighbour) && visit(neighbour))
+						{
+							queue.push_back(static_cast<uint16_t>(neighbour));
+						}
+						};
+					spread(cx > 0, index - Storage::Policy::StepX);
+					spread(cx < Last, index + Storage::Policy::StepX);
+					spread(cz > 0, index - Storage::Policy::StepY);
+					spread(cz < Last, index + Storage::Policy::StepY);
+					spread(cy > 0, index - Storage::Policy::StepZ);
+					spread(cy < Last, index + Storage::Policy::StepZ);
+				}
+
+				for (unsigned from{}; from < 6; ++from)
+				{
+					if (faces & (1u << from))
+					{
+						visibility |= static_cast<uint64_t>(faces) << (from * 6);
+					}
+				}
+			}
+		}
+	}
+	PendingVisibility = visibility;
+}
+
+void ChunkSection::AddFace(CubeType type, const glm::vec3& offset, float scale, Side side, unsigned occlusion, uint64_t light)
+{
+	SideFaces[side].push_back({ offset, scale, type, static_cast<uint8_t>(occlusion), light });
+}
+
+void ChunkSection::FinishMesh()
+{
+	size_t faceCount = 0;
+	for (const std::vector<StagedFace>& faces : SideFaces)
+	{
+		faceCount += faces.size();
+	}
+
+	if (faceCount > 0)
+	{
+		Mesh = MeshPool::AcquireData();
+		Mesh->Vertices.reserve(faceCount * 4);
+		Mesh->Indices.reserve(faceCount * 6);
+		for (unsigned side{}; side < 6; ++side)
+		{
+			for (const StagedFace& face : SideFaces[side])
+			{
+				const GLuint first = static_cast<GLuint>(Mesh->Vertices.size());
+				std::array<unsigned, 4> levels;
+				for (unsigned corner{}; corner < 4; ++corner)
+				{
+					levels[corner] = (face.Occlusion >> (corner * 2)) & 3u;
+					Vertex vertex = BlockRegistry::GetFaceVertex(face.Type, static_cast<Side>(side), corner);
+					vertex.Position = vertex.Position * face.Scale + face.Offset;
+					// Coarse LOD blocks repeat the tile instead of stretching it.
+					vertex.Texture.x *= face.Scale;
+					vertex.Texture.y *= face.Scale;
+					vertex.Tint = (vertex.Tint & 0x00FFFFFFu) | (OcclusionBrightness[levels[corner]] << 24);
+					vertex.Light = static_cast<GLuint>((face.Light >> (corner * 16)) & 0xFFFFu);
+					Mesh->Vertices.emplace_back(vertex);
+				}
+				// The quad is split along the diagonal with the lighter corners, so the shading
+				// doesn't change with the direction it is interpolated in.
+				const bool flip = levels[0] + levels[2] > levels[1] + levels[3];
+				for (GLuint index : { 0u, 1u, 2u, 2u, 3u, 0u })
+				{
+					Mesh->Indices.emplace_back(first + (flip ? (index + 1u) & 3u : index));
+				}
+			}
+			PendingSideCounts[side] = static_cast<GLsizei>(SideFaces[side].size() * 6);
+		}
+	}
+	PendingUpload = true;
+}
+
+bool ChunkSection::HasPendingMesh() const
+{
+	return PendingUpload;
+}
+
+const MeshData* ChunkSection::GetPendingMesh() const
+{
+	return Mesh && !Mesh->IsEmpty() ? Mesh.get() : nullptr;
+}
+
+const std::array<GLsizei, 6>& ChunkSection::GetPendingSideCounts() const
+{
+	return PendingSideCounts;
+}
+
+void ChunkSection::FinishUpload(const MeshRange& range)
+{
+	Range = range;
+	Visibility = PendingVisibility;
+	ReleaseMesh();
+	PendingUpload = false;
+}
+
+const MeshRange& ChunkSection::GetRange() const
+{
+	return Range;
+}
+
+void ChunkSection::DeleteMesh()
+{
+	Range = MeshRange();
+	Visibility = AllVisible;
+	ReleaseMesh();
+	PendingUpload = false;
+}
+
+void ChunkSection::ReleaseMesh()
+{
+	MeshPool::ReleaseData(std::move(Mesh));
+}
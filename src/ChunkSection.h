@@ -0,0 +1,114 @@
+#pragma once
+
+#include "glObjects/ShaderProgram.h"
+#include "MeshPool.h"
+#include "Vertex.h"
+#include "BlockRegistry.h"
+#include "Array3D.h"
+#include <array>
+#include <vector>
+#include <atomic>
+
+// Where a section's mesh lives inside its chunk's buffers, indices are relative to baseVertex.
+// Faces are grouped by Side in Side order, so each direction is a run of indices.
+struct MeshRange
+{
+	GLint baseVertex = 0;
+	GLsizei vertexCount = 0;
+	GLsizei firstIndex = 0;
+	GLsizei indexCount = 0;
+	std::array<GLsizei, 6> sideIndexCounts{};
+};
+
+// 16 blocks high slice of a chunk column with its own blocks and mesh.
+// Storage is only held while the section has at least one block, and comes from the ChunkPool.
+class ChunkSection
+{
+public:
+	static constexpr unsigned Size = 16u;
+	// Face light with every corner in full sky light and no block light.
+	static constexpr uint64_t FullSkyCorners = 0x00FF00FF00FF00FFull;
+	using Storage = FixedArray3D<CubeType, Size, Size, Size>;
+	using LightStorage = FixedArray3D<uint8_t, Size, Size, Size>;
+
+	ChunkSection();
+	ChunkSection(const ChunkSection&) = delete;
+	ChunkSection& operator=(const ChunkSection&) = delete;
+	~ChunkSection();
+
+	CubeType GetBlock(unsigned x, unsigned y, unsigned z) const;
+	void SetBlock(unsigned x, unsigned y, unsigned z, CubeType type);
+	// Size blocks from y = 0 up, null when the section is empty.
+	const CubeType* GetColumn(unsigned x, unsigned z) const;
+
+	// Light of every block, sky light in the high 4 bits and block light in the low ones, see LightEngine.
+	// Storage is only held once the light stops being the same everywhere.
+	uint8_t GetLight(unsigned x, unsigned y, unsigned z) const;
+	void SetLight(unsigned x, unsigned y, unsigned z, uint8_t light);
+	void FillLight(uint8_t light);
+	// Size values from y = 0 up, null when the light is the same everywhere.
+	const uint8_t* GetLightColumn(unsigned x, unsigned z) const;
+	uint8_t GetUniformLight() const;
+
+	bool IsEmpty() const;
+	// Every block is opaque, nothing inside can be seen.
+	bool IsFull() const;
+	// Drops blocks, light and mesh, ready to be reused by another chunk.
+	void Clear();
+
+	// Worker side, rebuilds the CPU mesh. A section's faces are added between its BeginMesh
+	// and FinishMesh on one thread, they are staged per Side and joined by FinishMesh.
+	void BeginMesh();
+	// Flood fills the see-through blocks to find which faces can see each other.
+	void UpdateVisibility();
+	// Every block type goes into the same mesh, tint and tile are per vertex.
+	// Occlusion holds how shadowed each corner is, 0 to 3 in 2 bits per corner in cube vertex order.
+	// Light holds the sky and block light of each corner, 0 to 255, one byte each in 16 bits per corner.
+	void AddFace(CubeType type, const glm::vec3& offset, float scale, Side side, unsigned occlusion = 0, uint64_t light = FullSkyCorners);
+	void FinishMesh();
+
+	// GL thread side, the chunk packs the section meshes into its buffers.
+	bool HasPendingMesh() const;
+	// Null when the new mesh has no faces.
+	const MeshData* GetPendingMesh() const;
+	// Index count of every Side in the pending mesh.
+	const std::array<GLsizei, 6>& GetPendingSideCounts() const;
+	void FinishUpload(const MeshRange& range);
+	const MeshRange& GetRange() const;
+	void DeleteMesh();
+
+	// Whether a line of sight entering through one face can leave through the other, as of the last upload.
+	bool CanSeeThrough(Side from, Side to) const
+	{
+		return (Visibility >> (from * 6 + to)) & 1u;
+	}
+
+public:
+	std::atomic<bool> Dirty{ true };
+
+private:
+	void ReleaseMesh();
+
+private:
+	// Blocks, indexed as at(x, z, y).
+	Storage Blocks;
+	unsigned SolidCount = 0; // Blocks that aren't EMPTY.
+	unsigned OpaqueCount = 0;
+
+	// Light, indexed like the blocks. UniformLight is used while there is no storage.
+	LightStorage Light;
+	uint8_t UniformLight = 0;
+
+	// CPU mesh, built by a worker and handed back to the MeshPool once uploaded.
+	std::unique_ptr<MeshData> Mesh;
+	std::array<GLsizei, 6> PendingSideCounts{};
+	bool PendingUpload = false;
+
+	// Uploaded mesh.
+	MeshRange Range;
+
+	// Face connectivity, bit from * 6 + to. Built with the mesh and published with it.
+	static constexpr uint64_t AllVisible = (1ull << 36) - 1;
+	uint64_t Visibility = AllVisible;
+	uint64_t PendingVisibility = AllVisible;
+};
@@ -26,7 +26,6 @@ void Cube::Draw(const ShaderProgram& shader, const Camera& camera, const glm::ma
 		return;
 
 	shader.Bind();
-	shader.SetLights(NO_LIGHT);
 	shader.BindUniformVec3("viewPos", camera.pos);
 
 	// Material Uniform.
@@ -39,6 +38,8 @@ void Cube::Draw(const ShaderProgram& shader, const Camera& camera, const glm::ma
 	glm::mat4 model = glm::mat4(1.0f);
 	model = glm::translate(model, Position);
 	shader.BindUniformMat4("model", glm::value_ptr(model));
+	const glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model))); // Lit variants only.
+	shader.BindUniformMat3("normalMatrix", glm::value_ptr(normalMatrix));
 	
 	// vao.Bind();
 	glDrawElements(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0);
@@ -67,7 +68,7 @@ CubeType Cube::Type() const
 	return type;
 }
 
-Texture2D Cube::Texture() const
+Texture2DArray Cube::Texture() const
 {
 	return atlas;
 }
@@ -82,17 +83,9 @@ void Cube::InitializeType()
 	if (type == CubeType::EMPTY)
 		return;
 
-	atlas = ResourceManager::GetTexture("atlas-1");
+	atlas = ResourceManager::GetTextureArray("atlas-1");
 	material.diffuse = atlas.unit;
 	material.shininess = 32.f;
-
-	switch (type) {
-	case GRASS:
-		material.tintTop = glm::vec3(0.6f, 0.7f, 0.3f) * 1.3f;
-		break;
-	default:
-		break;
-	}
 }
 
 void Cube::InitializeData()
@@ -100,7 +93,7 @@ void Cube::InitializeData()
 	if (type == CubeType::EMPTY)
 		return;
 
-	std::vector<GLfloat> vertices = TextureData::GetVerticesRaw(type);
+	std::vector<GLfloat> vertices = TextureData::GetVerticesRaw();
 	std::vector<GLuint> indices = TextureData::GetIndices();
 	Vertices = TextureData::GetVerticesFormatted(type);
 }
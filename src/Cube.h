@@ -3,7 +3,7 @@
 #include "glObjects/VAO.h"
 #include "glObjects/VBO.h"
 #include "glObjects/EBO.h"
-#include "glObjects/Texture2D.h"
+#include "glObjects/Texture2DArray.h"
 #include "glObjects/ShaderProgram.h"
 #include "glm/gtc/type_ptr.hpp"
 #include "ResourceManager.h"
@@ -21,7 +21,7 @@ public:
 	std::vector<Vertex> GetVerticesSide(const Side& side) const;
 
 	CubeType Type() const;
-	Texture2D Texture() const;
+	Texture2DArray Texture() const;
 	Material GetMaterial() const;
 
 private:
@@ -34,5 +34,5 @@ private:
 	Material material;
 	
 	// Textures.
-	Texture2D atlas;
+	Texture2DArray atlas;
 };
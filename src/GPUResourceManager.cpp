@@ -0,0 +1,160 @@
+#include "GPUResourceManager.h"
+#include <iostream>
+
+std::mutex GPUResourceManager::Mutex;
+std::array<std::unordered_map<GLuint, size_t>, GPU_RESOURCE_TYPE_COUNT> GPUResourceManager::Live;
+std::array<size_t, GPU_RESOURCE_TYPE_COUNT> GPUResourceManager::LiveBytes{};
+std::vector<std::pair<GPUResourceType, GLuint>> GPUResourceManager::PendingDeletes;
+
+GLuint GPUResourceManager::Create(GPUResourceType type)
+{
+	GLuint id = 0;
+	switch (type)
+	{
+	case GPUResourceType::VERTEX_ARRAY:
+		glGenVertexArrays(1, &id);
+		break;
+	case GPUResourceType::VERTEX_BUFFER:
+	case GPUResourceType::ELEMENT_BUFFER:
+	case GPUResourceType::TEXTURE_BUFFER:
+		glGenBuffers(1, &id);
+		break;
+	case GPUResourceType::TEXTURE:
+		glGenTextures(1, &id);
+		break;
+	default:
+		return 0;
+	}
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	Live[type][id] = 0;
+	return id;
+}
+
+void GPUResourceManager::SetSize(GPUResourceType type, GLuint id, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	auto found = Live[type].find(id);
+	if (found == Live[type].end())
+	{
+		return;
+	}
+
+	LiveBytes[type] = LiveBytes[type] - found->second + bytes;
+	found->second = bytes;
+}
+
+void GPUResourceManager::Release(GPUResourceType type, GLuint id)
+{
+	if (id == 0)
+	{
+		return;
+	}
+
+	// Unknown or already released ids are ignored, so shared handles can't be deleted twice.
+	std::lock_guard<std::mutex> lock(Mutex);
+	auto found = Live[type].find(id);
+	if (found == Live[type].end())
+	{
+		return;
+	}
+
+	LiveBytes[type] -= found->second;
+	Live[type].erase(found);
+	PendingDeletes.emplace_back(type, id);
+}
+
+void GPUResourceManager::CollectGarbage()
+{
+	std::vector<std::pair<GPUResourceType, GLuint>> deletes;
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		deletes.swap(PendingDeletes);
+	}
+
+	for (const auto& [type, id] : deletes)
+	{
+		Delete(type, id);
+	}
+}
+
+void GPUResourceManager::Clear()
+{
+	for (int type = 0; type < GPU_RESOURCE_TYPE_COUNT; ++type)
+	{
+		if (!Live[type].empty())
+		{
+			std::cout << "[GPU]: " << Live[type].size() << " objects of type " << type << " still alive on shutdown\n";
+		}
+
+		std::vector<GLuint> ids;
+		for (const auto& [id, bytes] : Live[type])
+		{
+			ids.emplace_back(id);
+		}
+		for (GLuint id : ids)
+		{
+			Release(static_cast<GPUResourceType>(type), id);
+		}
+	}
+	CollectGarbage();
+}
+
+size_t GPUResourceManager::GetLiveCount(GPUResourceType type)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return Live[type].size();
+}
+
+size_t GPUResourceManager::GetLiveBytes(GPUResourceType type)
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	return LiveBytes[type];
+}
+
+size_t GPUResourceManager::GetTotalLiveBytes()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	size_t total = 0;
+	for (size_t bytes : LiveBytes)
+	{
+		total += bytes;
+	}
+	return total;
+}
+
+void GPUResourceManager::PrintStats()
+{
+	static const char* const names[GPU_RESOURCE_TYPE_COUNT] = { "VAO", "VBO", "EBO", "Texture", "TBO" };
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	size_t total = 0;
+	for (int type = 0; type < GPU_RESOURCE_TYPE_COUNT; ++type)
+	{
+		std::cout << "[GPU:" << names[type] << "]: " << Live[type].size() << " live, "
+			<< LiveBytes[type] / 1024.0 << " KiB\n";
+		total += LiveBytes[type];
+	}
+	std::cout << "[GPU]: " << total / (1024.0 * 1024.0) << " MiB total, "
+		<< PendingDeletes.size() << " pending deletes\n";
+}
+
+void GPUResourceManager::Delete(GPUResourceType type, GLuint id)
+{
+	switch (type)
+	{
+	case GPUResourceType::VERTEX_ARRAY:
+		glDeleteVertexArrays(1, &id);
+		break;
+	case GPUResourceType::VERTEX_BUFFER:
+	case GPUResourceType::ELEMENT_BUFFER:
+	case GPUResourceType::TEXTURE_BUFFER:
+		glDeleteBuffers(1, &id);
+		break;
+	case GPUResourceType::TEXTURE:
+		glDeleteTextures(1, &id);
+		break;
+	default:
+		break;
+	}
+}
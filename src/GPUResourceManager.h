@@ -0,0 +1,48 @@
+#pragma once
+
+#include "GLAD/glad.h"
+#include <array>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+enum GPUResourceType
+{
+	VERTEX_ARRAY = 0,
+	VERTEX_BUFFER,
+	ELEMENT_BUFFER,
+	TEXTURE,
+	TEXTURE_BUFFER, // Storage behind a buffer texture.
+	GPU_RESOURCE_TYPE_COUNT,
+};
+
+// Owns every GL object created through the glObjects wrappers.
+// Creation happens on the GL thread, Release can be called from any thread and
+// the object is only deleted in CollectGarbage, once per frame on the GL thread.
+class GPUResourceManager
+{
+public:
+	static GLuint Create(GPUResourceType type);
+	// Bytes of storage behind the object, replaces the previous size.
+	static void SetSize(GPUResourceType type, GLuint id, size_t bytes);
+	static void Release(GPUResourceType type, GLuint id);
+
+	static void CollectGarbage();
+	static void Clear();
+
+	static size_t GetLiveCount(GPUResourceType type);
+	static size_t GetLiveBytes(GPUResourceType type);
+	static size_t GetTotalLiveBytes();
+	static void PrintStats();
+
+private:
+	GPUResourceManager() {}
+
+	static void Delete(GPUResourceType type, GLuint id);
+
+private:
+	static std::mutex Mutex;
+	static std::array<std::unordered_map<GLuint, size_t>, GPU_RESOURCE_TYPE_COUNT> Live;
+	static std::array<size_t, GPU_RESOURCE_TYPE_COUNT> LiveBytes;
+	static std::vector<std::pair<GPUResourceType, GLuint>> PendingDeletes;
+};
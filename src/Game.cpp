@@ -27,6 +27,7 @@ Game::Game(float width, float height)
 	{
 		PrintError("glad couldn't be loaded.");
 	}
+	ProgramCache::Init((GLADloadproc)glfwGetProcAddress);
 
 	// OpenGL
 	// ----------------------------------------
@@ -44,6 +45,11 @@ Game::Game(float width, float height)
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
 
+	// Samples shaded by the terrain, divided by the pixel count this is the overdraw.
+	terrainSamples.Init();
+	// Point light lists of the view frustum clusters, rebuilt every frame.
+	lightClusters.Init();
+
 	// My things
 	// ------------------------
 	// Initializing the shaders.
@@ -53,12 +59,26 @@ Game::Game(float width, float height)
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 	glfwSetCursorPosCallback(window, static_mouse_move_callback);
 	glfwSetScrollCallback(window, static_mouse_scroll_callback);
+	glfwSetMouseButtonCallback(window, static_mouse_button_callback);
 	glm::vec3 up{ 0.0f, 1.0f, 0.0f };
 	camera.Init(up);
 	camera.Move(glm::vec3(0.0f, 20.0f, 0.0f));
 
-	// Loading atlases.
-	ResourceManager::LoadTexture("atlas-1", "Resources/Textures/atlas_terrain.png", 0);
+	// Loading atlases and the blocks using them.
+	ResourceManager::LoadTextureArray("atlas-1", AtlasPath, AtlasTilesPerRow, 0);
+	// Without the registry every block is invisible and walked through, the world isn't worth starting.
+	if (!BlockRegistry::Load(BlocksPath, AtlasTilesPerRow, ResourceManager::GetTextureArray("atlas-1").layers))
+	{
+		PrintError("the block registry couldn't be loaded, stopping.");
+		return;
+	}
+	initialized = true;
+}
+
+bool Game::CookAssets()
+{
+	CookedTexture atlas;
+	return TextureCache::Cook(AtlasPath, AtlasTilesPerRow, atlas);
 }
 
 Game::~Game()
@@ -66,10 +86,19 @@ Game::~Game()
 	glfwTerminate();
 }
 
+bool Game::IsInitialized() const
+{
+	return initialized;
+}
+
 void Game::run()
 {
+	if (!initialized)
+	{
+		return;
+	}
+
 	ShaderProgram& defaultShader = ResourceManager::GetShader("default");
-	World world(16u);
 
 	float lastDT = 0.0f;
 	while (!glfwWindowShouldClose(window))
@@ -87,13 +116,19 @@ void Game::run()
 
 		update(deltaTime);
 		render();
+		GPUResourceManager::CollectGarbage(); // Nothing queued this frame is bound anymore.
 		
 		glfwSwapBuffers(window); // Swapping front and back buffers.
 		glfwPollEvents(); // Polling instructed user events so glfw can call respective callback functions to handle them.
 	}
 
-	ResourceManager::Clear();
 	world.Delete();
+	terrainSamples.Delete();
+	lightClusters.Delete();
+	ChunkPool::Clear();
+	MeshPool::Clear();
+	ResourceManager::Clear();
+	GPUResourceManager::Clear();
 	glfwTerminate();
 }
 
@@ -117,17 +152,117 @@ void Game::processInput(float dt)
 	{
 		camera.processInput(window, dt);
 	}
+	else
+	{
+		camera.velocity = glm::vec3(0.0f);
+	}
+
+	// F3 - GPU memory, culling, overdraw and, with lamps placed, light cluster stats.
+	const bool statsKey = glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS;
+	if (statsKey && !statsKeyDown)
+	{
+		GPUResourceManager::PrintStats();
+		world.PrintCullingStats();
+		if (!pointLights.empty())
+		{
+			lightClusters.PrintStats();
+		}
+		const SamplesQuery::Count samples = terrainSamples.GetResult();
+		std::cout << "[OVERDRAW]: " << samples.Samples << " terrain samples, "
+			<< (samples.Pixels ? static_cast<float>(samples.Samples) / samples.Pixels : 0.0f) << " per pixel\n";
+	}
+	statsKeyDown = statsKey;
+
+	// F2 - Raycast benchmark from the camera.
+	const bool benchmarkKey = glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS;
+	if (benchmarkKey && !benchmarkKeyDown)
+	{
+		world.BenchmarkRaycast(camera.pos, 100000u, world.GetViewDistance());
+	}
+	benchmarkKeyDown = benchmarkKey;
+
+	// F4 - Meshing benchmark on the loaded chunks.
+	const bool meshBenchmarkKey = glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS;
+	if (meshBenchmarkKey && !meshBenchmarkKeyDown)
+	{
+		world.BenchmarkMeshing(20u);
+	}
+	meshBenchmarkKeyDown = meshBenchmarkKey;
+
+	// F5 - Array3D layout benchmark on the loaded chunks.
+	const bool layoutBenchmarkKey = glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS;
+	if (layoutBenchmarkKey && !layoutBenchmarkKeyDown)
+	{
+		world.BenchmarkLayouts(20u);
+	}
+	layoutBenchmarkKeyDown = layoutBenchmarkKey;
+
+	// F6 - Light cluster build benchmark over the current view.
+	const bool clusterBenchmarkKey = glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS;
+	if (clusterBenchmarkKey && !clusterBenchmarkKeyDown)
+	{
+		lightClusters.Benchmark(1024u, 20u, camera.view, glm::radians(camera.fov), Width, Height, NearPlane, getFarPlane());
+	}
+	clusterBenchmarkKeyDown = clusterBenchmarkKey;
+
+	// L - Lamp at the camera, K - Remove every lamp.
+	const bool lampKey = glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS;
+	if (lampKey && !lampKeyDown)
+	{
+		pointLights.emplace_back(camera.pos, glm::vec3(0.05f), glm::vec3(1.0f, 0.8f, 0.5f), glm::vec3(0.3f), 1.0f, 0.35f, 0.44f);
+	}
+	lampKeyDown = lampKey;
+
+	const bool clearLampsKey = glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS;
+	if (clearLampsKey && !clearLampsKeyDown)
+	{
+		pointLights.clear();
+	}
+	clearLampsKeyDown = clearLampsKey;
+
+	// 1-9 - Block to place, by block registry id.
+	for (int key = GLFW_KEY_1; key <= GLFW_KEY_9; ++key)
+	{
+		const CubeType type = static_cast<CubeType>(key - GLFW_KEY_1);
+		if (glfwGetKey(window, key) == GLFW_PRESS && BlockRegistry::IsVisible(type))
+		{
+			placedBlock = type;
+		}
+	}
 }
 
 void Game::update(float dt)
 {
-	world.Update(camera.pos);
+	world.Update(camera.pos, camera.velocity);
 }
 
 void Game::render()
 {
-	glm::mat4 projection = glm::perspective(glm::radians(camera.fov), Width / Height, 0.1f, 100.0f);
-	world.Render(ResourceManager::GetShader("default"), camera, projection);
+	const float fovY = glm::radians(camera.fov);
+	glm::mat4 projection = glm::perspective(fovY, Width / Height, NearPlane, getFarPlane());
+
+	// Without lamps the unlit variant skips the lighting inputs altogether.
+	const ShaderProgram& terrainShader = ResourceManager::GetShader("default", pointLights.empty() ? SHADER_NO_LIGHT : SHADER_FULL);
+	if (terrainShader.HasPointLights())
+	{
+		lightClusters.Build(pointLights, camera.view, fovY, Width, Height, NearPlane, getFarPlane());
+		terrainShader.Bind();
+		// Sky and block light pass through the ambient term as the unlit variant shows them, the lamps add to it.
+		terrainShader.BindDirectLight(DirectLight(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f), glm::vec3(0.0f), glm::vec3(0.0f)));
+		// No spot light, its attenuation and cone are kept finite so the zero impact doesn't turn into NaN.
+		terrainShader.BindSpotLight(SpotLight(glm::vec3(0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f), glm::vec3(0.0f),
+			glm::vec3(0.0f), 1.0f, 0.0f, 1.0f, 0.0f, 0.0f));
+		// Left unset the cluster samplers read unit 0 next to the atlas array, and the draw fails.
+		lightClusters.Bind(terrainShader);
+	}
+	terrainSamples.Begin(static_cast<GLuint>(Width * Height));
+	world.Render(terrainShader, camera, projection);
+	terrainSamples.End();
+}
+
+float Game::getFarPlane() const
+{
+	return world.GetViewDistance() * 1.5f;
 }
 
 void Game::framebuffer_size_callback(int width, int height)
@@ -173,6 +308,29 @@ void Game::mouse_scroll_callback(double xoffset, double yoffset)
 	camera.updateSpeed(yoffset);
 }
 
+void Game::mouse_button_callback(int button, int action)
+{
+	if (cursorMode != CursorMode::DISABLED || action != GLFW_PRESS)
+	{
+		return;
+	}
+
+	const RaycastHit hit = world.Raycast(camera.pos, camera.front, reachDistance);
+	if (!hit.hit)
+	{
+		return;
+	}
+
+	if (button == GLFW_MOUSE_BUTTON_LEFT) // LMB - Break.
+	{
+		world.SetBlock(hit.block, CubeType::EMPTY);
+	}
+	else if (button == GLFW_MOUSE_BUTTON_RIGHT && hit.normal != glm::ivec3(0)) // RMB - Place.
+	{
+		world.SetBlock(hit.block + hit.normal, placedBlock);
+	}
+}
+
 void Game::static_framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
 	Game* game = static_cast<Game*>(glfwGetWindowUserPointer(window));
@@ -200,6 +358,15 @@ void Game::static_mouse_scroll_callback(GLFWwindow* window, double xoffset, doub
 	}
 }
 
+void Game::static_mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+	Game* game = static_cast<Game*>(glfwGetWindowUserPointer(window));
+	if (game)
+	{
+		game->mouse_button_callback(button, action);
+	}
+}
+
 void Game::setCursorMode(const CursorMode& mode)
 {
 	switch (mode)
@@ -12,8 +12,14 @@
 #include "glObjects/VBO.h"
 #include "glObjects/EBO.h"
 #include "glObjects/Camera.h"
+#include "glObjects/SamplesQuery.h"
 #include "ResourceManager.h"
+#include "GPUResourceManager.h"
+#include "ChunkPool.h"
+#include "MeshPool.h"
+#include "BlockRegistry.h"
 #include "World.h"
+#include "LightClusters.h"
 
 enum CursorMode {
 	DISABLED = 0,
@@ -36,26 +42,42 @@ public:
 
 	~Game();
 
+	// False when something the game can't run without failed to load, run then returns at once.
+	bool IsInitialized() const;
 	void run();
 
+	// Cooks every texture the game loads into the texture cache, no window is needed.
+	static bool CookAssets();
+
 private:
 	void processInput(float dt);
 	void update(float dt);
 	void render();
+	// Far plane covers the diagonal of the farthest LOD ring.
+	float getFarPlane() const;
 
 private:
 	void framebuffer_size_callback(int width, int height);
 	void mouse_move_callback(double xpos, double ypos);
 	void mouse_scroll_callback(double xoffset, double yoffset);
+	void mouse_button_callback(int button, int action);
 
 	static void static_framebuffer_size_callback(GLFWwindow* window, int width, int height);
 	static void static_mouse_move_callback(GLFWwindow* window, double xpos, double ypos);
 	static void static_mouse_scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+	static void static_mouse_button_callback(GLFWwindow* window, int button, int action, int mods);
 
 	void setCursorMode(const CursorMode& mode);
 
 private:
+	// Atlases.
+	static constexpr const char* AtlasPath = "Resources/Textures/atlas_terrain.png";
+	static constexpr unsigned AtlasTilesPerRow = 16u;
+	static constexpr const char* BlocksPath = "Resources/Blocks/blocks.txt";
+	static constexpr float NearPlane = 0.1f;
+
 	// Game state.
+	bool initialized = false;
 	GameState State = GameState::GAME_ACTIVE;
 	bool Keys[1024];
 
@@ -73,5 +95,21 @@ private:
 
 	// Game Objects.
 	World world;
+	SamplesQuery terrainSamples;
+
+	// Lamps placed by the player, the only point lights.
+	std::vector<PointLight> pointLights;
+	LightClusters lightClusters;
 	unsigned chunkXZSize = 16u;
+
+	// Block picking.
+	float reachDistance = 8.0f;
+	CubeType placedBlock = CubeType::DIRT;
+	bool benchmarkKeyDown = false;
+	bool meshBenchmarkKeyDown = false;
+	bool layoutBenchmarkKeyDown = false;
+	bool statsKeyDown = false;
+	bool clusterBenchmarkKeyDown = false;
+	bool lampKeyDown = false;
+	bool clearLampsKeyDown = false;
 };
@@ -0,0 +1,339 @@
+#include "LightClusters.h"
+#include "glm/gtc/constants.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <random>
+
+void LightClusters::Init()
+{
+	Lights = TextureBuffer(GL_RGBA32F, LightsUnit);
+	Clusters = TextureBuffer(GL_RG32UI, ClustersUnit);
+	Indices = TextureBuffer(GL_R32UI, IndicesUnit);
+}
+
+void LightClusters::Delete()
+{
+	Lights.Delete();
+	Clusters.Delete();
+	Indices.Delete();
+}
+
+void LightClusters::Build(const std::vector<PointLight>& lights, const glm::mat4& view, float fovY, float width, float height, float near, float far)
+{
+	// Minimised window, there are no tiles to split and nothing is drawn.
+	if (width <= 0.0f || height <= 0.0f)
+	{
+		return;
+	}
+
+	const glm::vec4 projection(fovY, width / height, near, far);
+	if (projection != Projection)
+	{
+		UpdateBounds(fovY, width, height, near, far);
+		Projection = projection;
+	}
+	Viewport = glm::vec2(width, height);
+
+	LightTexels.clear();
+	Links.clear();
+	for (const PointLight& light : lights)
+	{
+		const float range = GetRange(light);
+		const glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		const float depth = -center.z;
+		if (range <= 0.0f || depth + range < near || depth - range > far)
+		{
+			continue;
+		}
+
+		// Sphere against the clusters' boxes, the axes are tested apart since a box's x range
+		// only depends on its column and slice, and its y range on its row and slice.
+		const unsigned index = static_cast<unsigned>(LightTexels.size() / 4);
+		const float rangeSquared = range * range;
+		const unsigned lastSlice = GetSlice(depth + range);
+		for (unsigned slice = GetSlice(depth - range); slice <= lastSlice; ++slice)
+		{
+			const float sliceNear = SliceDepth[slice];
+			const float sliceFar = SliceDepth[slice + 1];
+			const float dz = std::max({ sliceNear - depth, depth - sliceFar, 0.0f });
+			const float left = rangeSquared - dz * dz;
+			if (left < 0.0f)
+			{
+				continue;
+			}
+
+			std::array<float, GridX> dx;
+			for (unsigned x{}; x < GridX; ++x)
+			{
+				const float low = std::min(TileX[x] * sliceNear, TileX[x] * sliceFar);
+				const float high = std::max(TileX[x + 1] * sliceNear, TileX[x + 1] * sliceFar);
+				const float distance = std::max({ low - center.x, center.x - high, 0.0f });
+				dx[x] = distance * distance;
+			}
+			for (unsigned y{}; y < GridY; ++y)
+			{
+				const float low = std::min(TileY[y] * sliceNear, TileY[y] * sliceFar);
+				const float high = std::max(TileY[y + 1] * sliceNear, TileY[y + 1] * sliceFar);
+				const float distance = std::max({ low - center.y, center.y - high, 0.0f });
+				const float rowLeft = left - distance * distance;
+				if (rowLeft < 0.0f)
+				{
+					continue;
+				}
+				for (unsigned x{}; x < GridX; ++x)
+				{
+					if (dx[x] <= rowLeft)
+					{
+						Links.emplace_back(GetClusterIndex(x, y, slice), index);
+					}
+				}
+			}
+		}
+
+		// Four texels a light, the attenuation terms ride in the colours' w.
+		LightTexels.emplace_back(light.position, range);
+		LightTexels.emplace_back(light.ambient, light.attenConstant);
+		LightTexels.emplace_back(light.diffuse, light.attenLinear);
+		LightTexels.emplace_back(light.specular, light.attenQuadratic);
+	}
+
+	// Counting sort by cluster, every cluster's lights end up next to each other.
+	ClusterLists.fill(glm::uvec2(0u));
+	for (const glm::uvec2& link : Links)
+	{
+		++ClusterLists[link.x].y;
+	}
+	unsigned offset = 0;
+	for (glm::uvec2& cluster : ClusterLists)
+	{
+		cluster.x = offset;
+		offset += cluster.y;
+		cluster.y = 0;
+	}
+	LightIndices.resize(Links.size());
+	for (const glm::uvec2& link : Links)
+	{
+		glm::uvec2& cluster = ClusterLists[link.x];
+		LightIndices[cluster.x + cluster.y++] = link.y;
+	}
+
+	Lights.Upload(LightTexels.data(), static_cast<GLsizeiptr>(LightTexels.size() * sizeof(glm::vec4)));
+	Clusters.Upload(ClusterLists.data(), static_cast<GLsizeiptr>(ClusterLists.size() * sizeof(glm::uvec2)));
+	Indices.Upload(LightIndices.data(), static_cast<GLsizeiptr>(LightIndices.size() * sizeof(GLuint)));
+}
+
+void LightClusters::Bind(const ShaderProgram& shader) const
+{
+	Lights.Bind();
+	Clusters.Bind();
+	Indices.Bind();
+
+	shader.BindUniform1i("pointLights", LightsUnit);
+	shader.BindUniform1i("lightClusters", ClustersUnit);
+	shader.BindUniform1i("lightIndices", IndicesUnit);
+	shader.BindUniformVec3("clusterGrid", static_cast<float>(GridX), static_cast<float>(GridY), static_cast<float>(GridZ));
+	shader.BindUniformVec2("clusterTileSize", Viewport.x / GridX, Viewport.y / GridY);
+	shader.BindUniformVec2("clusterDepth", Projection.z, Projection.w);
+	shader.BindUniform1f("clusterSliceScale", SliceScale);
+}
+
+void LightClusters::Unbind() const
+{
+	Lights.Unbind();
+	Clusters.Unbind();
+	Indices.Unbind();
+}
+
+float LightClusters::GetRange(const PointLight& light)
+{
+	// Solves brightest / (constant + linear * d + quadratic * d^2) = Cutoff for d.
+	const glm::vec3 brightest = glm::max(light.ambient, glm::max(light.diffuse, light.specular));
+	const float reach = std::max({ brightest.r, brightest.g, brightest.b }) / Cutoff - light.attenConstant;
+	if (reach <= 0.0f)
+	{
+		return 0.0f;
+	}
+	if (light.attenQuadratic > 0.0f)
+	{
+		const float linear = light.attenLinear;
+		return (-linear + std::sqrt(linear * linear + 4.0f * light.attenQuadratic * reach)) / (2.0f * light.attenQuadratic);
+	}
+	if (light.attenLinear > 0.0f)
+	{
+		return reach / light.attenLinear;
+	}
+	return std::numeric_limits<float>::max();
+}
+
+unsigned LightClusters::GetIndexCount() const
+{
+	return static_cast<unsigned>(LightIndices.size());
+}
+
+void LightClusters::PrintStats() const
+{
+	unsigned used = 0;
+	unsigned most = 0;
+	for (const glm::uvec2& cluster : ClusterLists)
+	{
+		used += cluster.y > 0;
+		most = std::max(most, cluster.y);
+	}
+
+	std::cout << "[CLUSTERS]: " << LightTexels.size() / 4 << " lights in view, " << GetIndexCount() << " indices, "
+		<< used << "/" << ClusterCount << " clusters lit, avg " << static_cast<float>(GetIndexCount()) / ClusterCount
+		<< " lights per cluster (" << (used ? static_cast<float>(GetIndexCount()) / used : 0.0f) << " per lit one), max "
+		<< most << "\n";
+}
+
+double LightClusters::Benchmark(unsigned lightCount, unsigned runs, const glm::mat4& view, float fovY, float width, float height, float near, float far)
+{
+	// Fixed seed so every run lights the same view space positions, torch sized ranges of about 23 blocks.
+	std::mt19937 random(1234u);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::uniform_real_distribution<float> depths(near, far);
+	const float tanY = std::tan(fovY * 0.5f);
+	const float tanX = tanY * width / std::max(height, 1.0f);
+	const glm::mat4 viewToWorld = glm::inverse(view);
+
+	std::vector<PointLight> lights;
+	lights.reserve(lightCount);
+	for (unsigned i = 0; i < lightCount; ++i)
+	{
+		const float depth = depths(random);
+		const glm::vec3 position(unit(random) * tanX * depth, unit(random) * tanY * depth, -depth);
+		lights.emplace_back(glm::vec3(viewToWorld * glm::vec4(position, 1.0f)), glm::vec3(0.05f), glm::vec3(0.8f),
+			glm::vec3(0.3f), 1.0f, 0.35f, 0.44f);
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned run = 0; run < runs; ++run)
+	{
+		Build(lights, view, fovY, width, height, near, far);
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	const double buildMs = elapsed.count() * 1000.0 / std::max(runs, 1u);
+	std::cout << "[CLUSTERS]: " << lightCount << " lights built in " << buildMs << " ms avg over " << runs << " runs\n";
+	PrintStats();
+	Check(lights, view, 100000u);
+	return buildMs;
+}
+
+// calculate_point_light_impact of the default shader on a white surface.
+static glm::vec3 ShadePointLight(const glm::vec3& position, const glm::vec3& ambient, const glm::vec3& diffuse, const glm::vec3& specular,
+	const glm::vec3& attenuation, float range, const glm::vec3& fragPos, const glm::vec3& normal, const glm::vec3& viewDir)
+{
+	static constexpr float Shininess = 32.0f;
+	const glm::vec3 lightDir = glm::normalize(position - fragPos);
+	const float dist = glm::length(position - fragPos);
+	const float fade = std::clamp(1.0f - std::pow(dist / range, 4.0f), 0.0f, 1.0f);
+	const float atten = fade * fade / (attenuation.x + attenuation.y * dist + attenuation.z * dist * dist);
+	const float diff = std::max(glm::dot(lightDir, normal), 0.0f);
+	const float spec = std::pow(std::max(glm::dot(glm::reflect(-lightDir, normal), viewDir), 0.0f), Shininess);
+	return (ambient + diffuse * diff + specular * spec) * atten;
+}
+
+float LightClusters::Check(const std::vector<PointLight>& lights, const glm::mat4& view, unsigned samples) const
+{
+	std::mt19937 random(4321u);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	const glm::mat4 viewToWorld = glm::inverse(view);
+	const glm::vec3 eye(viewToWorld[3]);
+
+	float worst = 0.0f;
+	double total = 0.0;
+	unsigned visible = 0;
+	for (unsigned i = 0; i < samples; ++i)
+	{
+		// A point inside the frustum, its cluster found the way find_cluster does on the GPU.
+		const float depth = Projection.z * std::pow(Projection.w / Projection.z, unit(random));
+		const float tileX = unit(random) * GridX;
+		const float tileY = unit(random) * GridY;
+		const unsigned x = std::min(static_cast<unsigned>(tileX), GridX - 1);
+		const unsigned y = std::min(static_cast<unsigned>(tileY), GridY - 1);
+		const float edgeX = TileX[x] + (TileX[x + 1] - TileX[x]) * (tileX - x);
+		const float edgeY = TileY[y] + (TileY[y + 1] - TileY[y]) * (tileY - y);
+		const glm::vec3 fragPos(viewToWorld * glm::vec4(edgeX * depth, edgeY * depth, -depth, 1.0f));
+		const glm::vec3 viewDir = glm::normalize(eye - fragPos);
+		const float theta = unit(random) * 2.0f * glm::pi<float>();
+		const float z = unit(random) * 2.0f - 1.0f;
+		const glm::vec3 normal(std::sqrt(1.0f - z * z) * std::cos(theta), z, std::sqrt(1.0f - z * z) * std::sin(theta));
+
+		glm::vec3 clustered(0.0f);
+		const glm::uvec2 cluster = ClusterLists[GetClusterIndex(x, y, GetSlice(depth))];
+		for (unsigned j = 0; j < cluster.y; ++j)
+		{
+			const glm::vec4* texels = &LightTexels[LightIndices[cluster.x + j] * 4];
+			clustered += ShadePointLight(glm::vec3(texels[0]), glm::vec3(texels[1]), glm::vec3(texels[2]), glm::vec3(texels[3]),
+				glm::vec3(texels[1].w, texels[2].w, texels[3].w), texels[0].w, fragPos, normal, viewDir);
+		}
+		glm::vec3 every(0.0f);
+		for (const PointLight& light : lights)
+		{
+			every += ShadePointLight(light.position, light.ambient, light.diffuse, light.specular,
+				glm::vec3(light.attenConstant, light.attenLinear, light.attenQuadratic), GetRange(light), fragPos, normal, viewDir);
+		}
+
+		const glm::vec3 difference = glm::abs(glm::min(every, 1.0f) - glm::min(clustered, 1.0f)) * 255.0f;
+		const float steps = std::max({ difference.r, difference.g, difference.b });
+		worst = std::max(worst, steps);
+		total += steps;
+		visible += steps >= 1.0f;
+	}
+
+	std::cout << "[CLUSTERS]: " << samples << " samples against every light, max difference " << worst
+		<< " steps, avg " << (samples ? total / samples : 0.0) << ", " << visible << " off by a step or more\n";
+	return worst;
+}
+
+const std::array<glm::uvec2, LightClusters::ClusterCount>& LightClusters::GetClusters() const
+{
+	return ClusterLists;
+}
+
+const std::vector<GLuint>& LightClusters::GetIndices() const
+{
+	return LightIndices;
+}
+
+unsigned LightClusters::GetClusterIndex(unsigned x, unsigned y, unsigned slice)
+{
+	return (slice * GridY + y) * GridX + x;
+}
+
+unsigned LightClusters::GetSlice(float depth) const
+{
+	const float near = Projection.z;
+	if (depth <= near)
+	{
+		return 0;
+	}
+	const float slice = std::floor(std::log(depth / near) * SliceScale);
+	return static_cast<unsigned>(std::min(slice, static_cast<float>(GridZ - 1)));
+}
+
+void LightClusters::UpdateBounds(float fovY, float width, float height, float near, float far)
+{
+	// Tile edges evenly spaced in NDC, at depth d the edge lies at TileX[x] * d.
+	const float tanY = std::tan(fovY * 0.5f);
+	const float tanX = tanY * width / height;
+	for (unsigned x{}; x <= GridX; ++x)
+	{
+		TileX[x] = (2.0f * x / GridX - 1.0f) * tanX;
+	}
+	for (unsigned y{}; y <= GridY; ++y)
+	{
+		TileY[y] = (2.0f * y / GridY - 1.0f) * tanY;
+	}
+
+	// Every slice is deeper than the one before it by the same ratio, so nearby slices stay thin.
+	SliceScale = GridZ / std::log(far / near);
+	for (unsigned slice{}; slice <= GridZ; ++slice)
+	{
+		SliceDepth[slice] = near * std::pow(far / near, static_cast<float>(slice) / GridZ);
+	}
+}
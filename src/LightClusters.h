@@ -0,0 +1,82 @@
+#pragma once
+
+#include "glObjects/ShaderProgram.h"
+#include "glObjects/TextureBuffer.h"
+#include "glm/glm.hpp"
+#include <array>
+#include <vector>
+
+// Clustered forward shading for point lights. The view frustum is split into GridX x GridY tiles
+// on screen and GridZ slices that grow exponentially with depth. Every frame each cluster gets the
+// list of lights whose range reaches into it, and fragments only loop the lights of their own
+// cluster, so a light costs nothing outside its range. Lights, the cluster lists and the light
+// indices they point into are uploaded as buffer textures, see the POINT_LIGHTING variant.
+class LightClusters
+{
+public:
+	static constexpr unsigned GridX = 16u;
+	static constexpr unsigned GridY = 9u;
+	static constexpr unsigned GridZ = 24u;
+	static constexpr unsigned ClusterCount = GridX * GridY * GridZ;
+	// A light's range ends where it adds less than one step of an 8 bit channel.
+	static constexpr float Cutoff = 1.0f / 256.0f;
+	static constexpr int LightsUnit = 2;
+	static constexpr int ClustersUnit = 3;
+	static constexpr int IndicesUnit = 4;
+
+	// GL thread.
+	void Init();
+	void Delete();
+
+	// GL thread, once a frame before drawing with a POINT_LIGHTING variant. The projection is a
+	// perspective one with a vertical fovY in radians, width and height are the viewport's.
+	void Build(const std::vector<PointLight>& lights, const glm::mat4& view, float fovY, float width, float height, float near, float far);
+	// The shader must be bound.
+	void Bind(const ShaderProgram& shader) const;
+	void Unbind() const;
+
+	// Distance at which the light falls under Cutoff, 0 when it never reaches it. The shader fades the
+	// light out to nothing there, so leaving it out of the clusters beyond changes no fragment.
+	static float GetRange(const PointLight& light);
+
+	// Light indices over every cluster in the last build, the sum of the per cluster loop counts.
+	unsigned GetIndexCount() const;
+	// Lights and cluster occupancy of the last build.
+	void PrintStats() const;
+	// Builds runs times for lightCount lights spread over the view frustum, prints the average build
+	// time and the stats of the last run. The next Build replaces the benchmark's lights.
+	double Benchmark(unsigned lightCount, unsigned runs, const glm::mat4& view, float fovY, float width, float height, float near, float far);
+	// Shades samples points over the view frustum with the lights of their cluster and with every
+	// light, the way the per-light loop did before clustering, and prints how far the two differ.
+	// Takes the lights and view of the last build, returns the largest difference in 8 bit steps.
+	float Check(const std::vector<PointLight>& lights, const glm::mat4& view, unsigned samples) const;
+	// Offset and count into the light indices, clusters run x fastest, then y, then slices.
+	const std::array<glm::uvec2, ClusterCount>& GetClusters() const;
+	const std::vector<GLuint>& GetIndices() const;
+	static unsigned GetClusterIndex(unsigned x, unsigned y, unsigned slice);
+	// Slice holding a view space depth, clamped to the grid.
+	unsigned GetSlice(float depth) const;
+
+private:
+	// View space bounds of the tile columns, rows and slices, rebuilt when the projection changes.
+	void UpdateBounds(float fovY, float width, float height, float near, float far);
+
+private:
+	TextureBuffer Lights;
+	TextureBuffer Clusters;
+	TextureBuffer Indices;
+
+	// Field of view, aspect ratio, near and far plane the bounds were built for.
+	glm::vec4 Projection{ 0.0f };
+	glm::vec2 Viewport{ 0.0f };
+	// x, y of every tile edge divided by the depth, and the depth of every slice edge.
+	std::array<float, GridX + 1> TileX{};
+	std::array<float, GridY + 1> TileY{};
+	std::array<float, GridZ + 1> SliceDepth{};
+	float SliceScale = 0.0f;
+
+	std::vector<glm::vec4> LightTexels;
+	std::vector<glm::uvec2> Links; // Cluster and light of every light in a cluster.
+	std::array<glm::uvec2, ClusterCount> ClusterLists{};
+	std::vector<GLuint> LightIndices;
+};
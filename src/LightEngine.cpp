@@ -0,0 +1,418 @@
+#include "LightEngine.h"
+#include "BlockRegistry.h"
+#include <algorithm>
+#include <bit>
+
+enum LightChannel
+{
+	SKY_LIGHT,
+	BLOCK_LIGHT,
+};
+
+// Cell of a neighbourhood, x and z run from -16 to 31 with the centre chunk at 0 to 15.
+// Level is the light a removed cell had, spread queues don't use it.
+struct LightNode
+{
+	int8_t X;
+	uint8_t Y;
+	int8_t Z;
+	uint8_t Level;
+};
+
+// Neighbour steps in Side order.
+static constexpr int Directions[6][3] = { { 0, 0, 1 }, { 0, 0, -1 }, { -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 } };
+
+// Queues are reused by every task on the thread.
+static thread_local std::vector<LightNode> SkyQueue;
+static thread_local std::vector<LightNode> BlockQueue;
+static thread_local std::vector<LightNode> SkyRemoved;
+static thread_local std::vector<LightNode> BlockRemoved;
+
+static void ClearQueues()
+{
+	SkyQueue.clear();
+	BlockQueue.clear();
+	SkyRemoved.clear();
+	BlockRemoved.clear();
+}
+
+// Light reads and writes across the chunks of a neighbourhood. Every write marks the sections
+// whose mesh reads the cell, they are handed to the chunks at the end.
+class LightVolume
+{
+public:
+	LightVolume(const LightNeighbourhood& chunks) : Chunks(chunks) {}
+
+	bool Contains(int x, int y, int z) const
+	{
+		return y >= 0 && y < static_cast<int>(Chunk::SizeY) && x >= -Span && x < 2 * Span && z >= -Span && z < 2 * Span
+			&& Chunks[ChunkIndex(x, z)];
+	}
+
+	CubeType GetBlock(int x, int y, int z) const
+	{
+		return Chunks[ChunkIndex(x, z)]->GetBlock(Local(x), y, Local(z));
+	}
+
+	unsigned Get(LightChannel channel, int x, int y, int z) const
+	{
+		const uint8_t light = Chunks[ChunkIndex(x, z)]->GetLight(Local(x), y, Local(z));
+		return channel == SKY_LIGHT ? LightEngine::GetSky(light) : LightEngine::GetBlock(light);
+	}
+
+	void Set(LightChannel channel, int x, int y, int z, unsigned level)
+	{
+		Chunk& chunk = *Chunks[ChunkIndex(x, z)];
+		const uint8_t light = chunk.GetLight(Local(x), y, Local(z));
+		const uint8_t updated = channel == SKY_LIGHT ? (light & 0x0Fu) | (level << 4) : (light & 0xF0u) | level;
+		chunk.SetLight(Local(x), y, Local(z), updated);
+
+		// Meshes and light volumes read the light of the cells around their blocks, one block into the neighbours.
+		for (int dx : { -1, 1 })
+		{
+			for (int dz : { -1, 1 })
+			{
+				if (!Contains(x + dx, 0, z + dz))
+				{
+					continue;
+				}
+				for (int dy : { -1, 1 })
+				{
+					const int cy = std::clamp(y + dy, 0, static_cast<int>(Chunk::SizeY) - 1);
+					Dirty[ChunkIndex(x + dx, z + dz)] |= 1u << (cy / ChunkSection::Size);
+				}
+			}
+		}
+	}
+
+	// Spreads light outwards from every queued cell, the queue is consumed.
+	void Spread(LightChannel channel, std::vector<LightNode>& queue)
+	{
+		for (size_t next{}; next < queue.size(); ++next)
+		{
+			const LightNode node = queue[next];
+			const unsigned level = Get(channel, node.X, node.Y, node.Z);
+			if (level <= 1)
+			{
+				continue;
+			}
+
+			for (unsigned side{}; side < 6; ++side)
+			{
+				const int x = node.X + Directions[side][0];
+				const int y = node.Y + Directions[side][1];
+				const int z = node.Z + Directions[side][2];
+				if (!Contains(x, y, z) || BlockRegistry::IsOpaque(GetBlock(x, y, z)))
+				{
+					continue;
+				}
+
+				const bool falling = channel == SKY_LIGHT && side == Side::BOTTOM && level == LightEngine::MaxLight;
+				const unsigned spread = falling ? level : level - 1;
+				if (Get(channel, x, y, z) < spread)
+				{
+					Set(channel, x, y, z, spread);
+					queue.push_back({ static_cast<int8_t>(x), static_cast<uint8_t>(y), static_cast<int8_t>(z), 0 });
+				}
+			}
+		}
+		queue.clear();
+	}
+
+	// Darkens every cell that was lit through the removed ones. Brighter cells at the edge of
+	// the darkened area are lit from elsewhere, they go into the queue to spread back in.
+	void Remove(LightChannel channel, std::vector<LightNode>& removed, std::vector<LightNode>& queue)
+	{
+		for (size_t next{}; next < removed.size(); ++next)
+		{
+			const LightNode node = removed[next];
+			for (unsigned side{}; side < 6; ++side)
+			{
+				const int x = node.X + Directions[side][0];
+				const int y = node.Y + Directions[side][1];
+				const int z = node.Z + Directions[side][2];
+				if (!Contains(x, y, z))
+				{
+					continue;
+				}
+				const unsigned level = Get(channel, x, y, z);
+				if (level == 0)
+				{
+					continue;
+				}
+
+				const LightNode neighbour{ static_cast<int8_t>(x), static_cast<uint8_t>(y), static_cast<int8_t>(z), static_cast<uint8_t>(level) };
+				const bool falling = channel == SKY_LIGHT && side == Side::BOTTOM && node.Level == LightEngine::MaxLight;
+				if (level < node.Level || (falling && level == LightEngine::MaxLight))
+				{
+					Set(channel, x, y, z, 0);
+					removed.push_back(neighbour);
+
+					// Emitters keep their own light.
+					const unsigned emission = channel == BLOCK_LIGHT ? BlockRegistry::GetLightEmission(GetBlock(x, y, z)) : 0;
+					if (emission > 0)
+					{
+						Set(channel, x, y, z, emission);
+						queue.push_back(neighbour);
+					}
+				}
+				else
+				{
+					queue.push_back(neighbour);
+				}
+			}
+		}
+		removed.clear();
+	}
+
+	void MarkDirty() const
+	{
+		for (unsigned index{}; index < Chunks.size(); ++index)
+		{
+			for (unsigned sections = Dirty[index]; sections != 0; sections &= sections - 1)
+			{
+				Chunks[index]->MarkSectionLightDirty(std::countr_zero(sections));
+			}
+		}
+	}
+
+private:
+	static constexpr int Span = static_cast<int>(ChunkSection::Size);
+
+	static unsigned ChunkIndex(int x, int z)
+	{
+		return static_cast<unsigned>((x + Span) / Span * 3 + (z + Span) / Span);
+	}
+
+	static unsigned Local(int coordinate)
+	{
+		return static_cast<unsigned>(coordinate + Span) % Span;
+	}
+
+private:
+	const LightNeighbourhood& Chunks;
+	std::array<unsigned, 9> Dirty{};
+};
+
+void LightEngine::LightChunk(Chunk& chunk, const uint16_t* skyTops)
+{
+	static_assert(Chunk::SizeX == ChunkSection::Size && Chunk::SizeZ == ChunkSection::Size, "Light neighbourhoods assume one section wide chunks.");
+	constexpr unsigned Size = ChunkSection::Size;
+
+	std::array<uint16_t, Chunk::SizeX * Chunk::SizeZ> tops;
+	for (unsigned x{}; x < Chunk::SizeX; ++x)
+	{
+		for (unsigned z{}; z < Chunk::SizeZ; ++z)
+		{
+			unsigned top = Chunk::SizeY;
+			if (skyTops)
+			{
+				top = skyTops[x * Chunk::SizeZ + z];
+			}
+			else
+			{
+				while (top > 0)
+				{
+					const unsigned index = (top - 1) / Size;
+					if (chunk.IsSectionEmpty(index))
+					{
+						top = index * Size;
+					}
+					else if (BlockRegistry::IsOpaque(chunk.GetBlock(x, top - 1, z)))
+					{
+						break;
+					}
+					else
+					{
+						--top;
+					}
+				}
+			}
+			tops[x * Chunk::SizeZ + z] = static_cast<uint16_t>(top);
+		}
+	}
+
+	// Sections above every top are all sky and below every top all dark, neither needs storage.
+	const unsigned lowest = *std::min_element(tops.begin(), tops.end());
+	const unsigned highest = *std::max_element(tops.begin(), tops.end());
+	for (unsigned index{}; index < Chunk::SectionCount; ++index)
+	{
+		const unsigned bottom = index * Size;
+		if (bottom >= highest)
+		{
+			chunk.FillSectionLight(index, FullSky);
+			continue;
+		}
+		chunk.FillSectionLight(index, 0);
+		if (bottom + Size <= lowest)
+		{
+			continue;
+		}
+		for (unsigned x{}; x < Chunk::SizeX; ++x)
+		{
+			for (unsigned z{}; z < Chunk::SizeZ; ++z)
+			{
+				for (unsigned y = std::max<unsigned>(bottom, tops[x * Chunk::SizeZ + z]); y < bottom + Size; ++y)
+				{
+					chunk.SetLight(x, y, z, FullSky);
+				}
+			}
+		}
+	}
+	chunk.SetLightStage(LIGHT_LOCAL);
+
+	LightNeighbourhood chunks{};
+	chunks[CenterChunk] = &chunk;
+	LightVolume volume(chunks);
+	ClearQueues();
+
+	// Sky light only spreads sideways from the part of a column above its neighbour's top.
+	for (unsigned x{}; x < Chunk::SizeX; ++x)
+	{
+		for (unsigned z{}; z < Chunk::SizeZ; ++z)
+		{
+			unsigned neighbourTop = 0;
+			for (unsigned side = Side::FRONT; side <= Side::RIGHT; ++side)
+			{
+				const int nx = static_cast<int>(x) + Directions[side][0];
+				const int nz = static_cast<int>(z) + Directions[side][2];
+				if (nx >= 0 && nx < static_cast<int>(Chunk::SizeX) && nz >= 0 && nz < static_cast<int>(Chunk::SizeZ))
+				{
+					neighbourTop = std::max<unsigned>(neighbourTop, tops[nx * Chunk::SizeZ + nz]);
+				}
+			}
+			for (unsigned y = tops[x * Chunk::SizeZ + z]; y < neighbourTop; ++y)
+			{
+				SkyQueue.push_back({ static_cast<int8_t>(x), static_cast<uint8_t>(y), static_cast<int8_t>(z), 0 });
+			}
+		}
+	}
+
+	for (unsigned index{}; index < Chunk::SectionCount; ++index)
+	{
+		if (chunk.IsSectionEmpty(index))
+		{
+			continue;
+		}
+		for (unsigned x{}; x < Chunk::SizeX; ++x)
+		{
+			for (unsigned z{}; z < Chunk::SizeZ; ++z)
+			{
+				for (unsigned y = index * Size; y < (index + 1) * Size; ++y)
+				{
+					const unsigned emission = BlockRegistry::GetLightEmission(chunk.GetBlock(x, y, z));
+					if (emission > 0)
+					{
+						volume.Set(BLOCK_LIGHT, x, y, z, emission);
+						BlockQueue.push_back({ static_cast<int8_t>(x), static_cast<uint8_t>(y), static_cast<int8_t>(z), 0 });
+					}
+				}
+			}
+		}
+	}
+
+	volume.Spread(SKY_LIGHT, SkyQueue);
+	volume.Spread(BLOCK_LIGHT, BlockQueue);
+	volume.MarkDirty();
+}
+
+void LightEngine::Link(const LightNeighbourhood& chunks)
+{
+	constexpr int Size = static_cast<int>(ChunkSection::Size);
+	LightVolume volume(chunks);
+	ClearQueues();
+
+	// Only the brighter cell of a pair more than a level apart has anything to give.
+	const auto seed = [&volume](LightChannel channel, std::vector<LightNode>& queue, int x, int y, int z, int ox, int oz) {
+		const unsigned inside = volume.Get(channel, x, y, z);
+		const unsigned outside = volume.Get(channel, ox, y, oz);
+		if (inside > outside + 1)
+		{
+			queue.push_back({ static_cast<int8_t>(x), static_cast<uint8_t>(y), static_cast<int8_t>(z), 0 });
+		}
+		else if (outside > inside + 1)
+		{
+			queue.push_back({ static_cast<int8_t>(ox), static_cast<uint8_t>(y), static_cast<int8_t>(oz), 0 });
+		}
+		};
+
+	for (unsigned side = Side::FRONT; side <= Side::RIGHT; ++side)
+	{
+		const int dx = Directions[side][0];
+		const int dz = Directions[side][2];
+		if (!chunks[(dx + 1) * 3 + (dz + 1)])
+		{
+			continue;
+		}
+
+		for (int i{}; i < Size; ++i)
+		{
+			// Border cell of the centre chunk and the one across from it.
+			const int x = dx < 0 ? 0 : dx > 0 ? Size - 1 : i;
+			const int z = dz < 0 ? 0 : dz > 0 ? Size - 1 : i;
+			for (int y{}; y < static_cast<int>(Chunk::SizeY); ++y)
+			{
+				seed(SKY_LIGHT, SkyQueue, x, y, z, x + dx, z + dz);
+				seed(BLOCK_LIGHT, BlockQueue, x, y, z, x + dx, z + dz);
+			}
+		}
+	}
+
+	volume.Spread(SKY_LIGHT, SkyQueue);
+	volume.Spread(BLOCK_LIGHT, BlockQueue);
+	volume.MarkDirty();
+}
+
+void LightEngine::Update(const LightNeighbourhood& chunks, const std::vector<glm::ivec3>& changed)
+{
+	LightVolume volume(chunks);
+	ClearQueues();
+
+	for (const glm::ivec3& position : changed)
+	{
+		const int x = position.x;
+		const int y = position.y;
+		const int z = position.z;
+		const LightNode node{ static_cast<int8_t>(x), static_cast<uint8_t>(y), static_cast<int8_t>(z), 0 };
+
+		for (LightChannel channel : { SKY_LIGHT, BLOCK_LIGHT })
+		{
+			const unsigned level = volume.Get(channel, x, y, z);
+			if (level > 0)
+			{
+				volume.Set(channel, x, y, z, 0);
+				(channel == SKY_LIGHT ? SkyRemoved : BlockRemoved).push_back({ node.X, node.Y, node.Z, static_cast<uint8_t>(level) });
+			}
+		}
+
+		const CubeType type = volume.GetBlock(x, y, z);
+		if (const unsigned emission = BlockRegistry::GetLightEmission(type); emission > 0)
+		{
+			volume.Set(BLOCK_LIGHT, x, y, z, emission);
+			BlockQueue.push_back(node);
+		}
+
+		// An open cell takes light from its neighbours again.
+		if (!BlockRegistry::IsOpaque(type))
+		{
+			for (unsigned side{}; side < 6; ++side)
+			{
+				const int nx = x + Directions[side][0];
+				const int ny = y + Directions[side][1];
+				const int nz = z + Directions[side][2];
+				if (volume.Contains(nx, ny, nz))
+				{
+					const LightNode neighbour{ static_cast<int8_t>(nx), static_cast<uint8_t>(ny), static_cast<int8_t>(nz), 0 };
+					SkyQueue.push_back(neighbour);
+					BlockQueue.push_back(neighbour);
+				}
+			}
+		}
+	}
+
+	volume.Remove(SKY_LIGHT, SkyRemoved, SkyQueue);
+	volume.Spread(SKY_LIGHT, SkyQueue);
+	volume.Remove(BLOCK_LIGHT, BlockRemoved, BlockQueue);
+	volume.Spread(BLOCK_LIGHT, BlockQueue);
+	volume.MarkDirty();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Chunk.h"
+#include "glm/glm.hpp"
+#include <array>
+#include <vector>
+
+// A chunk and its eight neighbours, indexed (dx + 1) * 3 + (dz + 1), the centre is 4.
+// Neighbours that are missing, compressed or not lit yet are null and block light.
+using LightNeighbourhood = std::array<Chunk*, 9>;
+
+// Sky and block light as breadth first flood fills, 4 bits each. Light loses a level for every
+// block it travels and stops at opaque blocks, full sky light also falls straight down without
+// fading. Light never travels more than MaxLight blocks sideways, so whatever happens in a chunk
+// only changes light inside its neighbourhood, and an edit only revisits the cells it lit or darkened.
+// Everything runs on worker threads that own every chunk they are given, see World::LaunchLightTask.
+class LightEngine
+{
+public:
+	static constexpr unsigned MaxLight = 15u;
+	static constexpr uint8_t FullSky = MaxLight << 4;
+	static constexpr unsigned CenterChunk = 4u;
+
+	static unsigned GetSky(uint8_t light)
+	{
+		return light >> 4;
+	}
+
+	static unsigned GetBlock(uint8_t light)
+	{
+		return light & 15u;
+	}
+
+	// The chunk's own light as if it had no neighbours: full sky light down every column to the
+	// first opaque block, the emitters, and both spread inside the chunk. Sky tops are the first
+	// open y of every column, x-major, scanned from the blocks when null.
+	static void LightChunk(Chunk& chunk, const uint16_t* skyTops = nullptr);
+	// Lets light flow both ways over the borders between the centre chunk and its neighbours.
+	// Sections whose light changed are marked light dirty, in every chunk of the neighbourhood.
+	static void Link(const LightNeighbourhood& chunks);
+	// Blocks changed at these centre chunk positions. The light they cut off or gave off is
+	// removed first, then the light around the removed cells is spread back in.
+	static void Update(const LightNeighbourhood& chunks, const std::vector<glm::ivec3>& changed);
+
+private:
+	LightEngine() {}
+};
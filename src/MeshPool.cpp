@@ -0,0 +1,141 @@
+#include "MeshPool.h"
+#include <cstddef>
+
+static_assert(sizeof(Vertex) == sizeof(GLfloat) * 9 + sizeof(GLuint) * 2, "Vertices are uploaded as they are laid out in memory.");
+
+std::mutex MeshPool::Mutex;
+std::array<std::vector<Buffers>, MeshPool::ClassCount> MeshPool::FreeBuffers;
+size_t MeshPool::PooledBytes = 0;
+std::vector<std::unique_ptr<MeshData>> MeshPool::FreeData;
+
+std::unique_ptr<MeshData> MeshPool::AcquireData()
+{
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (!FreeData.empty())
+		{
+			std::unique_ptr<MeshData> data = std::move(FreeData.back());
+			FreeData.pop_back();
+			return data;
+		}
+	}
+	return std::make_unique<MeshData>();
+}
+
+void MeshPool::ReleaseData(std::unique_ptr<MeshData> data)
+{
+	if (!data)
+	{
+		return;
+	}
+
+	data->Vertices.clear();
+	data->Indices.clear();
+
+	std::lock_guard<std::mutex> lock(Mutex);
+	if (FreeData.size() < MaxPooledData)
+	{
+		FreeData.emplace_back(std::move(data));
+	}
+}
+
+Buffers MeshPool::AcquireBuffers(size_t vertexCount)
+{
+	const unsigned sizeClass = GetSizeClass(vertexCount);
+	Buffers bfs;
+	if (sizeClass < ClassCount)
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		if (!FreeBuffers[sizeClass].empty())
+		{
+			bfs = FreeBuffers[sizeClass].back();
+			FreeBuffers[sizeClass].pop_back();
+			PooledBytes -= GetClassBytes(sizeClass);
+		}
+	}
+
+	if (bfs.vao.ID == 0)
+	{
+		const size_t vertexCapacity = GetVertexCapacity(sizeClass);
+		bfs.sizeClass = sizeClass;
+		bfs.vao.Init();
+		bfs.vao.Bind();
+		bfs.vbo = VBO(nullptr, vertexCapacity * sizeof(Vertex), GL_DYNAMIC_DRAW);
+		bfs.vao.LinkAttrib(0, 3, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, Position));
+		bfs.vao.LinkAttrib(1, 3, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, Texture));
+		bfs.vao.LinkAttrib(2, 3, GL_FLOAT, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+		bfs.vao.LinkAttrib(3, 4, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, Tint), GL_TRUE);
+		bfs.vao.LinkAttrib(4, 2, GL_UNSIGNED_BYTE, sizeof(Vertex), (void*)offsetof(Vertex, Light), GL_TRUE);
+		bfs.ebo = EBO(nullptr, vertexCapacity / 4 * 6 * sizeof(GLuint), GL_DYNAMIC_DRAW);
+	}
+	else
+	{
+		bfs.vao.Bind();
+	}
+	bfs.count = 0;
+	return bfs;
+}
+
+void MeshPool::ReleaseBuffers(const Buffers& buffers)
+{
+	if (buffers.vao.ID == 0)
+	{
+		return;
+	}
+
+	if (buffers.sizeClass < ClassCount)
+	{
+		std::lock_guard<std::mutex> lock(Mutex);
+		const size_t bytes = GetClassBytes(buffers.sizeClass);
+		if (PooledBytes + bytes <= MaxPooledBytes)
+		{
+			FreeBuffers[buffers.sizeClass].emplace_back(buffers);
+			PooledBytes += bytes;
+			return;
+		}
+	}
+	DeleteBuffers(buffers);
+}
+
+void MeshPool::Clear()
+{
+	std::lock_guard<std::mutex> lock(Mutex);
+	for (std::vector<Buffers>& free : FreeBuffers)
+	{
+		for (const Buffers& buffers : free)
+		{
+			DeleteBuffers(buffers);
+		}
+		free.clear();
+	}
+	PooledBytes = 0;
+	FreeData.clear();
+}
+
+unsigned MeshPool::GetSizeClass(size_t vertexCount)
+{
+	unsigned sizeClass = 0;
+	while (GetVertexCapacity(sizeClass) < vertexCount)
+	{
+		++sizeClass;
+	}
+	return sizeClass;
+}
+
+size_t MeshPool::GetVertexCapacity(unsigned sizeClass)
+{
+	return size_t(1) << (sizeClass + MinClassBits);
+}
+
+size_t MeshPool::GetClassBytes(unsigned sizeClass)
+{
+	const size_t vertexCapacity = GetVertexCapacity(sizeClass);
+	return vertexCapacity * sizeof(Vertex) + vertexCapacity / 4 * 6 * sizeof(GLuint);
+}
+
+void MeshPool::DeleteBuffers(const Buffers& buffers)
+{
+	buffers.ebo.Delete();
+	buffers.vbo.Delete();
+	buffers.vao.Delete();
+}
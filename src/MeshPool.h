@@ -0,0 +1,68 @@
+#pragma once
+
+#include "glObjects/VAO.h"
+#include "glObjects/VBO.h"
+#include "glObjects/EBO.h"
+#include "Vertex.h"
+#include <array>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct Buffers
+{
+	VAO vao;
+	VBO vbo;
+	EBO ebo;
+	GLsizei count = 0;
+	unsigned sizeClass = 0; // Vertex capacity is 2^(sizeClass + MinClassBits).
+};
+
+struct MeshData
+{
+	std::vector<Vertex> Vertices;
+	std::vector<GLuint> Indices;
+
+	bool IsEmpty() const
+	{
+		return Vertices.empty();
+	}
+};
+
+// Recycles CPU mesh buffers and GPU buffer sets so streaming chunks in and out
+// reuses memory instead of going through the allocator and the driver.
+// GPU sets are bucketed by power of two vertex capacity and refilled with glBufferSubData.
+class MeshPool
+{
+public:
+	// Any thread. The data is empty but keeps the capacity of the meshes it held before.
+	static std::unique_ptr<MeshData> AcquireData();
+	static void ReleaseData(std::unique_ptr<MeshData> data);
+
+	// GL thread, a recycled buffer set holding at least vertexCount vertices and their indices.
+	// The contents are undefined, the VAO is left bound so the caller can fill the buffers.
+	static Buffers AcquireBuffers(size_t vertexCount);
+	// Any thread, the set is deleted instead when the pool is full.
+	static void ReleaseBuffers(const Buffers& buffers);
+
+	static void Clear();
+
+private:
+	MeshPool() {}
+
+	static unsigned GetSizeClass(size_t vertexCount);
+	static size_t GetVertexCapacity(unsigned sizeClass);
+	static size_t GetClassBytes(unsigned sizeClass);
+	static void DeleteBuffers(const Buffers& buffers);
+
+private:
+	static constexpr unsigned MinClassBits = 6u;
+	static constexpr unsigned ClassCount = 12u;
+	static constexpr size_t MaxPooledBytes = 64u * 1024u * 1024u;
+	static constexpr size_t MaxPooledData = 256u;
+
+	static std::mutex Mutex;
+	static std::array<std::vector<Buffers>, ClassCount> FreeBuffers;
+	static size_t PooledBytes;
+	static std::vector<std::unique_ptr<MeshData>> FreeData;
+};
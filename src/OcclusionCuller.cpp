@@ -0,0 +1,182 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Points closer than this to the eye don't project reliably, anything touching them is left alone.
+static constexpr float NearW = 0.1f;
+
+// Corners are indexed by bits, 1 for x, 2 for y and 4 for z set to max.
+static glm::vec3 GetCorner(const glm::vec3& min, const glm::vec3& max, unsigned corner)
+{
+	return glm::vec3(corner & 1u ? max.x : min.x, corner & 2u ? max.y : min.y, corner & 4u ? max.z : min.z);
+}
+
+static float Edge(const glm::vec3& from, const glm::vec3& to, float x, float y)
+{
+	return (to.x - from.x) * (y - from.y) - (to.y - from.y) * (x - from.x);
+}
+
+void OcclusionCuller::Begin(const glm::mat4& viewProj)
+{
+	ViewProj = viewProj;
+	OccluderCount = 0;
+	Depth.assign(Width * Height, 0.0f);
+}
+
+void OcclusionCuller::AddOccluder(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d)
+{
+	std::array<glm::vec3, 4> screen;
+	if (!Project(a, screen[0]) || !Project(b, screen[1]) || !Project(c, screen[2]) || !Project(d, screen[3]))
+	{
+		return;
+	}
+	RasterizeTriangle(screen[0], screen[1], screen[2]);
+	RasterizeTriangle(screen[0], screen[2], screen[3]);
+	++OccluderCount;
+}
+
+void OcclusionCuller::Finish()
+{
+	// Level 0 keeps the farthest depth of every 3x3 neighbourhood, so texels only partly
+	// covered by an occluder or sloping away inside the texel never hide anything.
+	std::vector<float>& base = Levels[0];
+	base.resize(Width * Height);
+	for (unsigned y{}; y < Height; ++y)
+	{
+		for (unsigned x{}; x < Width; ++x)
+		{
+			float depth = Depth[y * Width + x];
+			for (unsigned ny = y > 0 ? y - 1 : y; ny <= std::min(y + 1, Height - 1); ++ny)
+			{
+				for (unsigned nx = x > 0 ? x - 1 : x; nx <= std::min(x + 1, Width - 1); ++nx)
+				{
+					depth = std::min(depth, Depth[ny * Width + nx]);
+				}
+			}
+			base[y * Width + x] = depth;
+		}
+	}
+
+	for (unsigned level = 1; level < LevelCount; ++level)
+	{
+		const std::vector<float>& source = Levels[level - 1];
+		const unsigned sourceWidth = Width >> (level - 1);
+		const unsigned width = Width >> level;
+		const unsigned height = Height >> level;
+		std::vector<float>& target = Levels[level];
+		target.resize(width * height);
+		for (unsigned y{}; y < height; ++y)
+		{
+			for (unsigned x{}; x < width; ++x)
+			{
+				const float* row = &source[(y * 2) * sourceWidth + x * 2];
+				target[y * width + x] = std::min({ row[0], row[1], row[sourceWidth], row[sourceWidth + 1] });
+			}
+		}
+	}
+}
+
+bool OcclusionCuller::IsOccluded(const glm::vec3& min, const glm::vec3& max) const
+{
+	glm::vec2 low(std::numeric_limits<float>::max());
+	glm::vec2 high(std::numeric_limits<float>::lowest());
+	float nearest = 0.0f;
+	for (unsigned corner{}; corner < 8; ++corner)
+	{
+		glm::vec3 screen;
+		if (!Project(GetCorner(min, max, corner), screen))
+		{
+			return false;
+		}
+		low = glm::min(low, glm::vec2(screen));
+		high = glm::max(high, glm::vec2(screen));
+		nearest = std::max(nearest, screen.z);
+	}
+
+	// Off screen is for frustum culling to decide.
+	if (high.x < 0.0f || high.y < 0.0f || low.x >= Width || low.y >= Height)
+	{
+		return false;
+	}
+	const unsigned x0 = static_cast<unsigned>(std::max(low.x, 0.0f));
+	const unsigned y0 = static_cast<unsigned>(std::max(low.y, 0.0f));
+	const unsigned x1 = static_cast<unsigned>(std::min(high.x, Width - 1.0f));
+	const unsigned y1 = static_cast<unsigned>(std::min(high.y, Height - 1.0f));
+
+	// The coarsest level where the rect still spans at most 3x3 texels.
+	const unsigned span = std::max(x1 - x0, y1 - y0);
+	unsigned level = 0;
+	while (level + 1 < LevelCount && (span >> level) > 1)
+	{
+		++level;
+	}
+
+	const std::vector<float>& depth = Levels[level];
+	const unsigned width = Width >> level;
+	for (unsigned y = y0 >> level; y <= y1 >> level; ++y)
+	{
+		for (unsigned x = x0 >> level; x <= x1 >> level; ++x)
+		{
+			if (nearest >= depth[y * width + x])
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+unsigned OcclusionCuller::GetOccluderCount() const
+{
+	return OccluderCount;
+}
+
+bool OcclusionCuller::Project(const glm::vec3& point, glm::vec3& screen) const
+{
+	const glm::vec4 clip = ViewProj * glm::vec4(point, 1.0f);
+	if (clip.w < NearW)
+	{
+		return false;
+	}
+	const float invW = 1.0f / clip.w;
+	screen = glm::vec3((clip.x * invW * 0.5f + 0.5f) * Width, (clip.y * invW * 0.5f + 0.5f) * Height, invW);
+	return true;
+}
+
+void OcclusionCuller::RasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	float area = Edge(a, b, c.x, c.y);
+	if (std::abs(area) < 1e-6f)
+	{
+		return;
+	}
+	// Either winding, the weights are flipped to be positive inside.
+	const float sign = area > 0.0f ? 1.0f : -1.0f;
+	area *= sign;
+
+	const int minX = std::max(static_cast<int>(std::floor(std::min({ a.x, b.x, c.x }))), 0);
+	const int minY = std::max(static_cast<int>(std::floor(std::min({ a.y, b.y, c.y }))), 0);
+	const int maxX = std::min(static_cast<int>(std::ceil(std::max({ a.x, b.x, c.x }))), static_cast<int>(Width) - 1);
+	const int maxY = std::min(static_cast<int>(std::ceil(std::max({ a.y, b.y, c.y }))), static_cast<int>(Height) - 1);
+
+	// Pixels count as covered when their centre is.
+	for (int y = minY; y <= maxY; ++y)
+	{
+		const float py = y + 0.5f;
+		for (int x = minX; x <= maxX; ++x)
+		{
+			const float px = x + 0.5f;
+			const float w0 = Edge(b, c, px, py) * sign;
+			const float w1 = Edge(c, a, px, py) * sign;
+			const float w2 = Edge(a, b, px, py) * sign;
+			if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+			{
+				continue;
+			}
+
+			float& depth = Depth[y * Width + x];
+			depth = std::max(depth, (w0 * a.z + w1 * b.z + w2 * c.z) / area);
+		}
+	}
+}
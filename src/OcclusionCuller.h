@@ -0,0 +1,42 @@
+#pragma once
+
+#include "glm/glm.hpp"
+#include <array>
+#include <vector>
+
+// Software occlusion culling. Surfaces known to be opaque are rasterized into a small depth
+// buffer, which is reduced into a hierarchical-Z pyramid (every level keeps the farthest
+// depth of 2x2 texels), and boxes to draw are tested against the level their screen rect
+// fits into. Depth is stored as 1 / w, so 0 is infinitely far and it interpolates linearly.
+class OcclusionCuller
+{
+public:
+	static constexpr unsigned Width = 256u;
+	static constexpr unsigned Height = 128u;
+	static constexpr unsigned LevelCount = 8u;
+
+	// Starts a frame, clears the depth buffer.
+	void Begin(const glm::mat4& viewProj);
+	// Planar quad lying on the surface of something opaque, corners in loop order.
+	// Quads crossing the near plane are skipped.
+	void AddOccluder(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& d);
+	// Builds the pyramid, call once every occluder is in.
+	void Finish();
+
+	// True when the box is behind the occluders everywhere it covers on screen.
+	bool IsOccluded(const glm::vec3& min, const glm::vec3& max) const;
+
+	unsigned GetOccluderCount() const;
+
+private:
+	// Screen position in pixels and 1 / w, false when the point is too close to or behind the eye.
+	bool Project(const glm::vec3& point, glm::vec3& screen) const;
+	void RasterizeTriangle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+
+private:
+	glm::mat4 ViewProj{ 1.0f };
+	unsigned OccluderCount = 0;
+
+	std::vector<float> Depth;
+	std::array<std::vector<float>, LevelCount> Levels;
+};
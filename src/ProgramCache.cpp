@@ -0,0 +1,164 @@
+#include "ProgramCache.h"
+#include "helpers.h"
+#include <cstdio>
+#include <vector>
+
+// ARB_get_program_binary enums, the generated loader only covers 3.3 core.
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+
+struct ProgramHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceHash;
+	uint64_t driverHash;
+	uint32_t binaryFormat;
+	uint32_t length;
+};
+
+ProgramCache::GetProgramBinaryProc ProgramCache::GetProgramBinary = nullptr;
+ProgramCache::ProgramBinaryProc ProgramCache::ProgramBinary = nullptr;
+ProgramCache::ProgramParameteriProc ProgramCache::ProgramParameteri = nullptr;
+uint64_t ProgramCache::DriverHash = 0;
+
+void ProgramCache::Init(GLADloadproc load)
+{
+	GetProgramBinary = reinterpret_cast<GetProgramBinaryProc>(load("glGetProgramBinary"));
+	ProgramBinary = reinterpret_cast<ProgramBinaryProc>(load("glProgramBinary"));
+	ProgramParameteri = reinterpret_cast<ProgramParameteriProc>(load("glProgramParameteri"));
+
+	// Drivers may expose the entry points and still support no binary formats at all.
+	GLint formats = 0;
+	if (GetProgramBinary && ProgramBinary && ProgramParameteri)
+	{
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+		glGetError();
+	}
+	if (formats <= 0)
+	{
+		GetProgramBinary = nullptr;
+		ProgramBinary = nullptr;
+		ProgramParameteri = nullptr;
+		return;
+	}
+
+	DriverHash = HashBytes(nullptr, 0);
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+	{
+		const char* value = reinterpret_cast<const char*>(glGetString(name));
+		const std::string text = value ? value : "";
+		DriverHash = HashBytes(text.c_str(), text.size() + 1, DriverHash);
+	}
+}
+
+bool ProgramCache::IsEnabled()
+{
+	return ProgramBinary != nullptr;
+}
+
+GLuint ProgramCache::Load(const std::string& cachePath, uint64_t sourceHash)
+{
+	if (!IsEnabled())
+	{
+		return 0;
+	}
+
+	FILE* file = fopen(cachePath.c_str(), "rb");
+	if (!file)
+	{
+		return 0;
+	}
+
+	ProgramHeader header{};
+	std::vector<char> binary;
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& header.magic == Magic
+		&& header.version == Version
+		&& header.sourceHash == sourceHash
+		&& header.driverHash == DriverHash
+		&& header.length > 0;
+	if (valid)
+	{
+		binary.resize(header.length);
+		valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+	}
+	fclose(file);
+
+	if (!valid)
+	{
+		return 0;
+	}
+
+	// The driver may still refuse a binary it wrote itself, the caller then links from source.
+	GLuint program = glCreateProgram();
+	ProgramBinary(program, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+	GLint success = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glDeleteProgram(program);
+		return 0;
+	}
+	return program;
+}
+
+void ProgramCache::PrepareLink(GLuint program)
+{
+	if (IsEnabled())
+	{
+		ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+}
+
+bool ProgramCache::Store(const std::string& cachePath, uint64_t sourceHash, GLuint program)
+{
+	if (!IsEnabled())
+	{
+		return false;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return false;
+	}
+
+	std::vector<char> binary(length);
+	GLenum binaryFormat = 0;
+	GLsizei written = 0;
+	GetProgramBinary(program, length, &written, &binaryFormat, binary.data());
+	if (written <= 0)
+	{
+		return false;
+	}
+
+	ProgramHeader header{};
+	header.magic = Magic;
+	header.version = Version;
+	header.sourceHash = sourceHash;
+	header.driverHash = DriverHash;
+	header.binaryFormat = binaryFormat;
+	header.length = static_cast<uint32_t>(written);
+
+	// Written aside and renamed, so a crash never leaves a torn entry behind.
+	const std::string tempPath = cachePath + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool stored = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(binary.data(), 1, header.length, file) == header.length;
+	stored = fclose(file) == 0 && stored;
+
+	std::remove(cachePath.c_str());
+	if (!stored || std::rename(tempPath.c_str(), cachePath.c_str()) != 0)
+	{
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
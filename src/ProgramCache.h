@@ -0,0 +1,39 @@
+#pragma once
+
+#include "GLAD/glad.h"
+#include <cstdint>
+#include <string>
+
+// Linked program binaries stored on disk, keyed by a hash of the shader sources and of the
+// driver (vendor, renderer, version), so a driver update or an edited shader rebuilds them.
+// Program binaries are core in 4.1 only, the loader here is 3.3, so the entry points come
+// from ARB_get_program_binary and the cache quietly stays off where it isn't exposed.
+class ProgramCache
+{
+public:
+	// Must be called once the context is current.
+	static void Init(GLADloadproc load);
+	static bool IsEnabled();
+
+	// Creates the program from the cache, returns 0 when the entry is missing, stale or rejected.
+	static GLuint Load(const std::string& cachePath, uint64_t sourceHash);
+	// Asks the driver to keep the binary retrievable, call before linking.
+	static void PrepareLink(GLuint program);
+	static bool Store(const std::string& cachePath, uint64_t sourceHash, GLuint program);
+
+private:
+	ProgramCache() {}
+
+private:
+	typedef void (APIENTRYP GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	typedef void (APIENTRYP ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	typedef void (APIENTRYP ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+
+	static GetProgramBinaryProc GetProgramBinary;
+	static ProgramBinaryProc ProgramBinary;
+	static ProgramParameteriProc ProgramParameteri;
+	static uint64_t DriverHash;
+
+	static constexpr uint32_t Magic = 0x4750594Du; // "MYPG"
+	static constexpr uint32_t Version = 1u;
+};
@@ -0,0 +1,342 @@
+#include "RLEChunk.h"
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+RLEColumn::Cursor::Cursor(const RLEColumn& column)
+	: Run(column.First), Last(column.Last), RunEnd(0)
+{
+	if (Run != Last)
+	{
+		RunEnd = Run->Length;
+	}
+}
+
+CubeType RLEColumn::Cursor::TypeAt(unsigned y)
+{
+	while (Run != Last && y >= RunEnd)
+	{
+		++Run;
+		if (Run != Last)
+		{
+			RunEnd += Run->Length;
+		}
+	}
+	return Run == Last ? CubeType::EMPTY : Run->Type;
+}
+
+CubeType RLEColumn::TypeAt(unsigned y) const
+{
+	unsigned end = 0;
+	for (const RLERun* run = First; run != Last; ++run)
+	{
+		end += run->Length;
+		if (y < end)
+		{
+			return run->Type;
+		}
+	}
+	return CubeType::EMPTY;
+}
+
+bool RLEColumn::IsEmpty() const
+{
+	return First == Last;
+}
+
+void RLEChunk::Init(unsigned x, unsigned y, unsigned z)
+{
+	X = x;
+	Y = y;
+	Z = z;
+	Clear();
+}
+
+void RLEChunk::Clear()
+{
+	Runs.clear();
+	Offsets.clear();
+	Offsets.emplace_back(0u);
+}
+
+void RLEChunk::PushRun(CubeType type, unsigned length)
+{
+	if (length == 0)
+	{
+		return;
+	}
+
+	const bool columnHasRuns = Runs.size() > Offsets.back();
+	if (columnHasRuns && Runs.back().Type == type)
+	{
+		Runs.back().Length += static_cast<uint16_t>(length);
+		return;
+	}
+	Runs.push_back({ type, static_cast<uint16_t>(length) });
+}
+
+void RLEChunk::EndColumn()
+{
+	// Air on top of the column is implicit.
+	if (Runs.size() > Offsets.back() && Runs.back().Type == CubeType::EMPTY)
+	{
+		Runs.pop_back();
+	}
+	Offsets.emplace_back(static_cast<uint32_t>(Runs.size()));
+}
+
+RLEColumn RLEChunk::Column(unsigned x, unsigned z) const
+{
+	const unsigned column = x * Z + z;
+	const RLERun* data = Runs.data();
+	return RLEColumn(data + Offsets[column], data + Offsets[column + 1]);
+}
+
+CubeType RLEChunk::TypeAt(unsigned x, unsigned y, unsigned z) const
+{
+	return Column(x, z).TypeAt(y);
+}
+
+void RLEChunk::FromDense(const Array3D<CubeType>& dense)
+{
+	Clear();
+	for (unsigned x{}; x < X; ++x)
+	{
+		for (unsigned z{}; z < Z; ++z)
+		{
+			for (unsigned y{}; y < Y; ++y)
+			{
+				PushRun(dense.at(x, z, y), 1u);
+			}
+			EndColumn();
+		}
+	}
+	ShrinkToFit();
+}
+
+void RLEChunk::ToDense(Array3D<CubeType>& dense) const
+{
+	for (unsigned x{}; x < X; ++x)
+	{
+		for (unsigned z{}; z < Z; ++z)
+		{
+			unsigned y = 0;
+			for (const RLESpan& span : Column(x, z))
+			{
+				for (; y < span.End; ++y)
+				{
+					dense.at(x, z, y) = span.Type;
+				}
+			}
+			for (; y < Y; ++y)
+			{
+				dense.at(x, z, y) = CubeType::EMPTY;
+			}
+		}
+	}
+}
+
+RLEChunk RLEChunk::Downsample(unsigned factor) const
+{
+	RLEChunk result;
+	result.Init(X / factor, (Y + factor - 1) / factor, Z / factor);
+
+	const unsigned cellVolume = factor * factor * factor;
+	std::vector<unsigned> solidCount(result.Y);
+	std::vector<CubeType> cellTypes(result.Y);
+	std::vector<int> cellTops(result.Y);
+
+	for (unsigned x{}; x < result.X; ++x)
+	{
+		for (unsigned z{}; z < result.Z; ++z)
+		{
+			std::fill(solidCount.begin(), solidCount.end(), 0u);
+			std::fill(cellTops.begin(), cellTops.end(), -1);
+			CubeType surfaceType = CubeType::EMPTY;
+			int surfaceY = -1;
+
+			for (unsigned fx = x * factor; fx < (x + 1) * factor; ++fx)
+			{
+				for (unsigned fz = z * factor; fz < (z + 1) * factor; ++fz)
+				{
+					for (const RLESpan& span : Column(fx, fz))
+					{
+						if (span.Type == CubeType::EMPTY)
+						{
+							continue;
+						}
+
+						for (unsigned y = span.Begin; y < span.End;)
+						{
+							const unsigned cell = y / factor;
+							const unsigned cellEnd = std::min(span.End, (cell + 1) * factor);
+							const int top = static_cast<int>(cellEnd) - 1;
+							solidCount[cell] += cellEnd - y;
+							if (top > cellTops[cell])
+							{
+								cellTops[cell] = top;
+								cellTypes[cell] = span.Type;
+							}
+							if (top > surfaceY)
+							{
+								surfaceY = top;
+								surfaceType = span.Type;
+							}
+							y = cellEnd;
+						}
+					}
+				}
+			}
+
+			int highestSolid = -1;
+			for (unsigned cell{}; cell < result.Y; ++cell)
+			{
+				if (solidCount[cell] * 2 >= cellVolume)
+				{
+					highestSolid = static_cast<int>(cell);
+				}
+			}
+
+			for (unsigned cell{}; cell < result.Y; ++cell)
+			{
+				if (solidCount[cell] * 2 < cellVolume)
+				{
+					result.PushRun(CubeType::EMPTY, 1u);
+				}
+				else
+				{
+					result.PushRun(static_cast<int>(cell) == highestSolid ? surfaceType : cellTypes[cell], 1u);
+				}
+			}
+			result.EndColumn();
+		}
+	}
+
+	result.ShrinkToFit();
+	return result;
+}
+
+void RLEChunk::ShrinkToFit()
+{
+	Runs.shrink_to_fit();
+	Offsets.shrink_to_fit();
+}
+
+size_t RLEChunk::MemoryUsage() const
+{
+	return sizeof(RLEChunk) + Runs.capacity() * sizeof(RLERun) + Offsets.capacity() * sizeof(uint32_t);
+}
+
+void RLEChunk::Serialize(std::vector<uint8_t>& data) const
+{
+	auto put16 = [&data](unsigned value) {
+		data.push_back(static_cast<uint8_t>(value & 0xFFu));
+		data.push_back(static_cast<uint8_t>(value >> 8));
+	};
+
+	data.clear();
+	data.insert(data.end(), std::begin(Magic), std::end(Magic));
+	data.push_back(Version);
+	put16(X);
+	put16(Y);
+	put16(Z);
+	for (size_t column = 0; column + 1 < Offsets.size(); ++column)
+	{
+		put16(Offsets[column + 1] - Offsets[column]);
+		for (uint32_t run = Offsets[column]; run < Offsets[column + 1]; ++run)
+		{
+			data.push_back(static_cast<uint8_t>(Runs[run].Type));
+			put16(Runs[run].Length);
+		}
+	}
+}
+
+bool RLEChunk::Deserialize(const uint8_t* data, size_t size, unsigned x, unsigned y, unsigned z)
+{
+	Init(x, y, z);
+
+	size_t position = 0;
+	auto get16 = [data, size, &position](unsigned& value) {
+		if (size - position < 2)
+		{
+			return false;
+		}
+		value = data[position] | data[position + 1] << 8;
+		position += 2;
+		return true;
+	};
+
+	unsigned sizeX, sizeY, sizeZ;
+	bool valid = size > sizeof(Magic) && std::equal(std::begin(Magic), std::end(Magic), data)
+		&& data[sizeof(Magic)] == Version;
+	position = sizeof(Magic) + 1;
+	valid = valid && get16(sizeX) && get16(sizeY) && get16(sizeZ) && sizeX == X && sizeY == Y && sizeZ == Z;
+
+	for (unsigned column{}; valid && column < X * Z; ++column)
+	{
+		unsigned runCount = 0;
+		valid = get16(runCount) && size - position >= runCount * 3u;
+		unsigned height = 0;
+		for (unsigned run{}; valid && run < runCount; ++run)
+		{
+			const CubeType type = static_cast<CubeType>(data[position++]);
+			unsigned length = 0;
+			get16(length);
+			height += length;
+			valid = length > 0 && height <= Y;
+			PushRun(type, length);
+		}
+		EndColumn();
+	}
+
+	if (!valid || position != size)
+	{
+		Clear();
+		return false;
+	}
+	ShrinkToFit();
+	return true;
+}
+
+bool RLEChunk::Save(const std::string& path) const
+{
+	std::vector<uint8_t> data;
+	Serialize(data);
+
+	const std::string tempPath = path + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+	bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+	written = fclose(file) == 0 && written;
+
+	std::remove(path.c_str());
+	if (!written || std::rename(tempPath.c_str(), path.c_str()) != 0)
+	{
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool RLEChunk::Load(const std::string& path, unsigned x, unsigned y, unsigned z)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+	{
+		Init(x, y, z);
+		return false;
+	}
+
+	std::vector<uint8_t> data;
+	uint8_t buffer[4096];
+	size_t read;
+	while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + read);
+	}
+	fclose(file);
+	return Deserialize(data.data(), data.size(), x, y, z);
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "TextureData.h"
+#include "Array3D.h"
+#include <vector>
+#include <cstdint>
+#include <string>
+
+struct RLERun
+{
+	CubeType Type;
+	uint16_t Length;
+};
+
+struct RLESpan
+{
+	CubeType Type;
+	unsigned Begin;
+	unsigned End;
+};
+
+// Read-only view over the runs of one (x, z) column, ordered bottom to top.
+// Everything above the last run is EMPTY.
+class RLEColumn
+{
+public:
+	class Iterator
+	{
+	public:
+		Iterator(const RLERun* run, unsigned begin) : Run(run), Begin(begin) {}
+
+		RLESpan operator*() const
+		{
+			return { Run->Type, Begin, Begin + Run->Length };
+		}
+
+		Iterator& operator++()
+		{
+			Begin += Run->Length;
+			++Run;
+			return *this;
+		}
+
+		bool operator!=(const Iterator& other) const
+		{
+			return Run != other.Run;
+		}
+
+	private:
+		const RLERun* Run;
+		unsigned Begin;
+	};
+
+	// Forward-only lookup for non-decreasing y, amortized O(1) per call.
+	class Cursor
+	{
+	public:
+		Cursor() : Run(nullptr), Last(nullptr), RunEnd(0) {}
+		Cursor(const RLEColumn& column);
+
+		CubeType TypeAt(unsigned y);
+
+	private:
+		const RLERun* Run;
+		const RLERun* Last;
+		unsigned RunEnd;
+	};
+
+public:
+	RLEColumn(const RLERun* first, const RLERun* last) : First(first), Last(last) {}
+
+	Iterator begin() const { return Iterator(First, 0u); }
+	Iterator end() const { return Iterator(Last, 0u); }
+
+	CubeType TypeAt(unsigned y) const;
+	bool IsEmpty() const;
+
+private:
+	const RLERun* First;
+	const RLERun* Last;
+};
+
+// Run-length encoded voxel storage of a whole chunk, one column per (x, z).
+// Dense arrays are indexed as at(x, z, y), the same way Chunk lays them out.
+class RLEChunk
+{
+public:
+	RLEChunk() : X(0), Y(0), Z(0) {}
+
+	void Init(unsigned x, unsigned y, unsigned z);
+	void Clear();
+
+	// Columns have to be pushed in x-major order, EndColumn() closes the current one.
+	void PushRun(CubeType type, unsigned length);
+	void EndColumn();
+
+	RLEColumn Column(unsigned x, unsigned z) const;
+	CubeType TypeAt(unsigned x, unsigned y, unsigned z) const;
+
+	void FromDense(const Array3D<CubeType>& dense);
+	void ToDense(Array3D<CubeType>& dense) const;
+
+	// Coarser copy where every factor^3 cell is solid when at least half of it is,
+	// the topmost solid cell of a column keeps the column's surface type.
+	RLEChunk Downsample(unsigned factor) const;
+
+	unsigned SizeX() const { return X; }
+	unsigned SizeY() const { return Y; }
+	unsigned SizeZ() const { return Z; }
+
+	void ShrinkToFit();
+	size_t MemoryUsage() const;
+
+	// On-disk form: magic, a version byte, the dimensions, then every column as its run count and
+	// runs of a type byte and a 16 bit length. Little endian, written byte by byte.
+	void Serialize(std::vector<uint8_t>& data) const;
+	// False, with the chunk left empty, for torn data, another version or other dimensions.
+	bool Deserialize(const uint8_t* data, size_t size, unsigned x, unsigned y, unsigned z);
+	// Written aside and renamed, so a crash never leaves a torn file behind.
+	bool Save(const std::string& path) const;
+	bool Load(const std::string& path, unsigned x, unsigned y, unsigned z);
+
+private:
+	static constexpr uint8_t Magic[4] = { 'M', 'Y', 'C', 'K' };
+	static constexpr uint8_t Version = 1u;
+
+private:
+	std::vector<RLERun> Runs;
+	std::vector<uint32_t> Offsets;
+	unsigned X, Y, Z;
+};
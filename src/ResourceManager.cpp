@@ -1,7 +1,8 @@
 #include "ResourceManager.h"
 
-std::unordered_map<std::string, ShaderProgram>	ResourceManager::Shaders;
+std::unordered_map<std::string, ShaderVariants>	ResourceManager::Shaders;
 std::unordered_map<std::string, Texture2D>		ResourceManager::Textures;
+std::unordered_map<std::string, Texture2DArray>	ResourceManager::TextureArrays;
 
 Texture2D& ResourceManager::LoadTexture(const std::string& name, const char* filepath, int unit)
 {
@@ -17,7 +18,21 @@ Texture2D& ResourceManager::GetTexture(const std::string& name)
     return Textures[name];
 }
 
-ShaderProgram& ResourceManager::LoadShader(const std::string& name, const char* vertexSourcePath, const char* fragmentSourcePath)
+Texture2DArray& ResourceManager::LoadTextureArray(const std::string& name, const char* filepath, unsigned tilesPerRow, int unit)
+{
+    if (!TextureArrays.contains(name))
+    {
+        TextureArrays[name] = Texture2DArray(filepath, tilesPerRow, unit);
+    }
+    return TextureArrays[name];
+}
+
+Texture2DArray& ResourceManager::GetTextureArray(const std::string& name)
+{
+    return TextureArrays[name];
+}
+
+ShaderVariants& ResourceManager::LoadShader(const std::string& name, const char* vertexSourcePath, const char* fragmentSourcePath)
 {
     if (!doesShaderExist(name))
     {
@@ -26,9 +41,9 @@ ShaderProgram& ResourceManager::LoadShader(const std::string& name, const char*
     return Shaders[name];
 }
 
-ShaderProgram& ResourceManager::GetShader(const std::string& name)
+ShaderProgram& ResourceManager::GetShader(const std::string& name, ShaderVariant variant)
 {
-    return Shaders[name];
+    return Shaders[name][variant];
 }
 
 void ResourceManager::Clear()
@@ -38,10 +53,18 @@ void ResourceManager::Clear()
         entry.second.Delete();
     }
 
-    for (auto& entry : Shaders)
+    for (auto& entry : TextureArrays)
     {
         entry.second.Delete();
     }
+
+    for (auto& entry : Shaders)
+    {
+        for (ShaderProgram& shader : entry.second)
+        {
+            shader.Delete();
+        }
+    }
 }
 
 Texture2D ResourceManager::loadTexture(const char* filepath, int unit)
@@ -50,10 +73,14 @@ Texture2D ResourceManager::loadTexture(const char* filepath, int unit)
     return texture;
 }
 
-ShaderProgram ResourceManager::loadShader(const char* vertexSourcePath, const char* fragmentSourcePath)
+ShaderVariants ResourceManager::loadShader(const char* vertexSourcePath, const char* fragmentSourcePath)
 {
-    ShaderProgram shader(vertexSourcePath, fragmentSourcePath);
-    return shader;
+    ShaderVariants shaders;
+    for (unsigned variant{}; variant < SHADER_VARIANT_COUNT; ++variant)
+    {
+        shaders[variant].Init(vertexSourcePath, fragmentSourcePath, static_cast<ShaderVariant>(variant));
+    }
+    return shaders;
 }
 
 bool ResourceManager::doesTextureExist(const std::string& name)
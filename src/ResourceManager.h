@@ -3,6 +3,7 @@
 #include "glObjects/ShaderProgram.h"
 #include <unordered_map>
 #include "glObjects/Texture2D.h"
+#include "glObjects/Texture2DArray.h"
 
 class ResourceManager
 {
@@ -10,8 +11,13 @@ public:
 	static Texture2D& LoadTexture(const std::string& name, const char* filepath, int unit);
 	static Texture2D& GetTexture(const std::string& name);
 
-	static ShaderProgram& LoadShader(const std::string& name, const char* vertexSourcePath, const char* fragmentSourcePath);
-	static ShaderProgram& GetShader(const std::string& name);
+	// Tile atlas sliced into a texture array, one layer per tile.
+	static Texture2DArray& LoadTextureArray(const std::string& name, const char* filepath, unsigned tilesPerRow, int unit);
+	static Texture2DArray& GetTextureArray(const std::string& name);
+
+	// Compiles every ShaderVariant of the shader, passes then pick the one they need.
+	static ShaderVariants& LoadShader(const std::string& name, const char* vertexSourcePath, const char* fragmentSourcePath);
+	static ShaderProgram& GetShader(const std::string& name, ShaderVariant variant = SHADER_FULL);
 
 	static void Clear();
 
@@ -19,12 +25,13 @@ private:
 	ResourceManager() {}
 
 	static Texture2D loadTexture(const char* filepath, int unit);
-	static ShaderProgram loadShader(const char* vertexSourcePath, const char* fragmentSourcePath);
+	static ShaderVariants loadShader(const char* vertexSourcePath, const char* fragmentSourcePath);
 
 	static bool doesTextureExist(const std::string& name);
 	static bool doesShaderExist(const std::string& name);
 
 public:
-	static std::unordered_map<std::string, ShaderProgram> Shaders;
+	static std::unordered_map<std::string, ShaderVariants> Shaders;
 	static std::unordered_map<std::string, Texture2D> Textures;
+	static std::unordered_map<std::string, Texture2DArray> TextureArrays;
 };
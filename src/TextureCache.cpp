@@ -0,0 +1,271 @@
+#include "TextureCache.h"
+#include "helpers.h"
+#include "stb_image/stb_image.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+// On-disk layout: header, level table, padding up to DataAlignment, pixels.
+struct CacheHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	uint32_t tilesPerRow;
+	uint32_t layers;
+	uint32_t levelCount;
+	uint32_t reserved;
+};
+
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+bool TextureCache::Load(const char* sourcePath, unsigned tilesPerRow, CookedTexture& texture)
+{
+	SourceStamp stamp{};
+	if (!GetSourceStamp(sourcePath, stamp))
+	{
+		PrintError("Couldn't load the texture source.");
+		return false;
+	}
+
+	if (ReadCache(GetCachePath(sourcePath), stamp, tilesPerRow, texture))
+	{
+		return true;
+	}
+	return Cook(sourcePath, tilesPerRow, texture);
+}
+
+bool TextureCache::Cook(const char* sourcePath, unsigned tilesPerRow, CookedTexture& texture)
+{
+	// Stamped before reading, an edit made meanwhile misses the cache next time instead of hiding.
+	SourceStamp stamp{};
+	const std::string source = GetSourceStamp(sourcePath, stamp) ? GetFileContent(sourcePath) : std::string();
+	int width, height, channels;
+	stbi_set_flip_vertically_on_load(1);
+	unsigned char* data = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(source.data()), static_cast<int>(source.size()), &width, &height, &channels, 4);
+	if (!data)
+	{
+		PrintError("Couldn't load the texture source.");
+		return false;
+	}
+
+	const unsigned tileSize = width / tilesPerRow;
+	const unsigned tilesPerColumn = height / tileSize;
+	texture.tilesPerRow = tilesPerRow;
+	texture.layers = tilesPerRow * tilesPerColumn;
+
+	// Tiles are copied out row by row so each layer is contiguous.
+	const size_t rowBytes = static_cast<size_t>(tileSize) * 4;
+	const size_t layerBytes = rowBytes * tileSize;
+	texture.pixels.assign(layerBytes * texture.layers, 0);
+	for (unsigned ty{}; ty < tilesPerColumn; ++ty)
+	{
+		for (unsigned tx{}; tx < tilesPerRow; ++tx)
+		{
+			const size_t layer = static_cast<size_t>(ty) * tilesPerRow + tx;
+			for (unsigned row{}; row < tileSize; ++row)
+			{
+				const size_t offset = (static_cast<size_t>(ty * tileSize + row) * width + tx * tileSize) * 4;
+				memcpy(&texture.pixels[(layer * tileSize + row) * rowBytes], &data[offset], rowBytes);
+			}
+		}
+	}
+	stbi_image_free(data);
+
+	GenerateLevels(texture, tileSize);
+
+	if (!WriteCache(GetCachePath(sourcePath), stamp, texture))
+	{
+		PrintError("Couldn't write the texture cache.");
+	}
+	return true;
+}
+
+std::string TextureCache::GetCachePath(const char* sourcePath)
+{
+	return std::string(sourcePath) + ".cooked";
+}
+
+bool TextureCache::GetSourceStamp(const char* sourcePath, SourceStamp& stamp)
+{
+	std::error_code error;
+	const uintmax_t size = std::filesystem::file_size(sourcePath, error);
+	if (error || size == 0)
+	{
+		return false;
+	}
+	const std::filesystem::file_time_type time = std::filesystem::last_write_time(sourcePath, error);
+	if (error)
+	{
+		return false;
+	}
+
+	stamp.size = static_cast<uint64_t>(size);
+	stamp.time = static_cast<int64_t>(time.time_since_epoch().count());
+	return true;
+}
+
+bool TextureCache::ReadCache(const std::string& cachePath, const SourceStamp& stamp, unsigned tilesPerRow, CookedTexture& texture)
+{
+	std::error_code error;
+	const uintmax_t fileSize = std::filesystem::file_size(cachePath, error);
+	FILE* file = error ? nullptr : fopen(cachePath.c_str(), "rb");
+	if (!file)
+	{
+		return false;
+	}
+
+	CacheHeader header{};
+	bool valid = fread(&header, sizeof(header), 1, file) == 1
+		&& header.magic == Magic
+		&& header.version == Version
+		&& header.sourceSize == stamp.size
+		&& header.sourceTime == stamp.time
+		&& header.tilesPerRow == tilesPerRow
+		&& header.layers > 0 && header.layers <= MaxLayers && header.layers % tilesPerRow == 0
+		&& header.levelCount > 0 && header.levelCount <= 32;
+
+	if (valid)
+	{
+		texture.tilesPerRow = header.tilesPerRow;
+		texture.layers = header.layers;
+		texture.levels.resize(header.levelCount);
+		valid = fread(texture.levels.data(), sizeof(CookedLevel), header.levelCount, file) == header.levelCount;
+	}
+
+	const uint64_t dataOffset = AlignUp(sizeof(CacheHeader) + sizeof(CookedLevel) * header.levelCount, DataAlignment);
+	if (valid && ValidateLevels(texture, dataOffset, static_cast<uint64_t>(fileSize)))
+	{
+		const CookedLevel& last = texture.levels.back();
+		texture.pixels.resize(last.offset + last.size);
+		valid = fseek(file, static_cast<long>(dataOffset), SEEK_SET) == 0
+			&& fread(texture.pixels.data(), 1, texture.pixels.size(), file) == texture.pixels.size();
+	}
+	else
+	{
+		valid = false;
+	}
+
+	fclose(file);
+	if (!valid)
+	{
+		texture = CookedTexture();
+	}
+	return valid;
+}
+
+bool TextureCache::ValidateLevels(const CookedTexture& texture, uint64_t dataOffset, uint64_t fileSize)
+{
+	// Square tiles, every level halves the one before it down to 1x1, each one aligned right after it.
+	const CookedLevel& first = texture.levels.front();
+	if (first.width == 0 || first.width > MaxLevelSize || first.height != first.width || first.offset != 0)
+	{
+		return false;
+	}
+	for (size_t i{}; i < texture.levels.size(); ++i)
+	{
+		const CookedLevel& level = texture.levels[i];
+		if (i > 0)
+		{
+			const CookedLevel& previous = texture.levels[i - 1];
+			if (level.width != std::max(previous.width / 2, 1u) || level.height != std::max(previous.height / 2, 1u)
+				|| level.offset != AlignUp(previous.offset + previous.size, DataAlignment))
+			{
+				return false;
+			}
+		}
+		if (level.size != static_cast<uint64_t>(level.width) * level.height * 4 * texture.layers)
+		{
+			return false;
+		}
+	}
+
+	const CookedLevel& last = texture.levels.back();
+	return last.width == 1 && last.height == 1 && dataOffset + last.offset + last.size <= fileSize;
+}
+
+bool TextureCache::WriteCache(const std::string& cachePath, const SourceStamp& stamp, const CookedTexture& texture)
+{
+	// Written aside and renamed, so a crash never leaves a torn cache behind.
+	const std::string tempPath = cachePath + ".tmp";
+	FILE* file = fopen(tempPath.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	CacheHeader header{};
+	header.magic = Magic;
+	header.version = Version;
+	header.sourceSize = stamp.size;
+	header.sourceTime = stamp.time;
+	header.tilesPerRow = texture.tilesPerRow;
+	header.layers = texture.layers;
+	header.levelCount = static_cast<uint32_t>(texture.levels.size());
+
+	const uint64_t tableEnd = sizeof(CacheHeader) + sizeof(CookedLevel) * texture.levels.size();
+	const char padding[DataAlignment]{};
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(texture.levels.data(), sizeof(CookedLevel), texture.levels.size(), file) == texture.levels.size()
+		&& fwrite(padding, 1, AlignUp(tableEnd, DataAlignment) - tableEnd, file) == AlignUp(tableEnd, DataAlignment) - tableEnd
+		&& fwrite(texture.pixels.data(), 1, texture.pixels.size(), file) == texture.pixels.size();
+	written = fclose(file) == 0 && written;
+
+	std::remove(cachePath.c_str());
+	if (!written || std::rename(tempPath.c_str(), cachePath.c_str()) != 0)
+	{
+		std::remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+void TextureCache::GenerateLevels(CookedTexture& texture, unsigned tileSize)
+{
+	// Level 0 is already in place, every next level is a 2x2 box filter of the previous one.
+	texture.levels.clear();
+	texture.levels.push_back({ tileSize, tileSize, 0, static_cast<uint64_t>(tileSize) * tileSize * 4 * texture.layers });
+
+	while (texture.levels.back().width > 1 || texture.levels.back().height > 1)
+	{
+		const CookedLevel source = texture.levels.back();
+		CookedLevel level{};
+		level.width = source.width > 1 ? source.width / 2 : 1;
+		level.height = source.height > 1 ? source.height / 2 : 1;
+		level.offset = AlignUp(source.offset + source.size, DataAlignment);
+		level.size = static_cast<uint64_t>(level.width) * level.height * 4 * texture.layers;
+		texture.pixels.resize(level.offset + level.size);
+
+		const unsigned stepX = source.width / level.width;
+		const unsigned stepY = source.height / level.height;
+		for (uint32_t layer{}; layer < texture.layers; ++layer)
+		{
+			const unsigned char* from = &texture.pixels[source.offset + static_cast<uint64_t>(layer) * source.width * source.height * 4];
+			unsigned char* to = &texture.pixels[level.offset + static_cast<uint64_t>(layer) * level.width * level.height * 4];
+			for (uint32_t y{}; y < level.height; ++y)
+			{
+				for (uint32_t x{}; x < level.width; ++x)
+				{
+					for (unsigned channel{}; channel < 4; ++channel)
+					{
+						unsigned sum = 0;
+						for (unsigned dy{}; dy < stepY; ++dy)
+						{
+							for (unsigned dx{}; dx < stepX; ++dx)
+							{
+								sum += from[((y * stepY + dy) * source.width + x * stepX + dx) * 4 + channel];
+							}
+						}
+						to[(y * level.width + x) * 4 + channel] = static_cast<unsigned char>((sum + stepX * stepY / 2) / (stepX * stepY));
+					}
+				}
+			}
+		}
+		texture.levels.push_back(level);
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Level of a cooked texture, offsets are relative to the start of the pixel data.
+struct CookedLevel
+{
+	uint32_t width;
+	uint32_t height;
+	uint64_t offset;
+	uint64_t size;
+};
+
+// Tile atlas decoded, sliced into layers and mipmapped ahead of time, RGBA8.
+struct CookedTexture
+{
+	uint32_t tilesPerRow = 0;
+	uint32_t layers = 0;
+	std::vector<CookedLevel> levels;
+	std::vector<unsigned char> pixels;
+};
+
+// Size and modification time of a source file.
+struct SourceStamp
+{
+	uint64_t size;
+	int64_t time;
+};
+
+// Binary cache of cooked texture arrays stored next to the source as "<source>.cooked".
+// The file is a fixed header, the level table and the raw pixels, aligned so it can be
+// mapped and handed to GL as is. Entries are keyed by the source's size and modification
+// time, so a hit never reads the image, and an edited one is cooked again through stb.
+class TextureCache
+{
+public:
+	// Uses the cache when it is up to date, otherwise cooks the source and refreshes the cache.
+	static bool Load(const char* sourcePath, unsigned tilesPerRow, CookedTexture& texture);
+	// Decodes, slices and mipmaps the source and writes the cache file.
+	static bool Cook(const char* sourcePath, unsigned tilesPerRow, CookedTexture& texture);
+
+	static std::string GetCachePath(const char* sourcePath);
+
+private:
+	TextureCache() {}
+
+	static bool GetSourceStamp(const char* sourcePath, SourceStamp& stamp);
+	static bool ReadCache(const std::string& cachePath, const SourceStamp& stamp, unsigned tilesPerRow, CookedTexture& texture);
+	// The level table has to be the one GenerateLevels builds for the header's layers, and its
+	// pixels have to fit in the file, anything else is a torn or corrupt cache.
+	static bool ValidateLevels(const CookedTexture& texture, uint64_t dataOffset, uint64_t fileSize);
+	static bool WriteCache(const std::string& cachePath, const SourceStamp& stamp, const CookedTexture& texture);
+	static void GenerateLevels(CookedTexture& texture, unsigned tileSize);
+
+private:
+	static constexpr uint32_t Magic = 0x5854594Du; // "MYTX"
+	static constexpr uint32_t Version = 2u;
+	static constexpr uint64_t DataAlignment = 16u;
+	// Past GL's guarantees, and small enough that sizes computed from them can't overflow.
+	static constexpr uint32_t MaxLevelSize = 16384u;
+	static constexpr uint32_t MaxLayers = 65536u;
+};
@@ -4,9 +4,11 @@
 #include <vector>
 #include <array>
 #include <unordered_map>
+#include <cstdint>
 #include "Vertex.h"
 
-enum CubeType
+// Block id, the rest of the ids are defined by the BlockRegistry's data file.
+enum CubeType : uint8_t
 {
 	DIRT,
 	GRASS,
@@ -26,18 +28,12 @@ enum Side
 class TextureData
 {
 public:
-	static std::vector<GLfloat> GetVerticesRaw(const CubeType& type = CubeType::EMPTY);
+	// Unit cube, position, uv and normal per vertex, four vertices a face in Side order.
+	static std::vector<GLfloat> GetVerticesRaw();
 	static std::vector<GLuint> GetIndices();
+	// Layers and tints come from the BlockRegistry, EMPTY gives the plain unit cube.
 	static std::vector<Vertex> GetVerticesFormatted(const CubeType& type = CubeType::EMPTY);
-	
-	static void SetTextureSize(unsigned size);
 
 private:
 	TextureData() {};
-
-	static void LocationToCoords(std::vector<GLfloat>& vertices, const CubeType& type);
-
-private:
-	static unsigned TextureSize;
-	static const std::unordered_map<CubeType, std::unordered_map<Side, std::array<GLuint, 2>>> TextureLocations;
 };
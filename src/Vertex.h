@@ -7,21 +7,29 @@
 struct Vertex
 {
 	glm::vec3 Position;
-	glm::vec2 Texture;
+	glm::vec3 Texture; // u, v and the texture array layer.
 	glm::vec3 Normal;
+	GLuint Tint = 0xFFFFFFFFu; // RGBA8 multiplied into the tile colour, lets block types share one draw. Alpha is the corner brightness.
+	GLuint Light = 0x000000FFu; // Sky light then block light, one byte each, 255 is level 15.
 
-	Vertex(const glm::vec3& position, const glm::vec2& texture, const glm::vec3& normal)
+	Vertex(const glm::vec3& position, const glm::vec3& texture, const glm::vec3& normal)
 		: Position(position), Texture(texture), Normal(normal)
 	{}
 
-	Vertex(GLfloat px, GLfloat py, GLfloat pz, GLfloat tx, GLfloat ty, GLfloat nx, GLfloat ny, GLfloat nz)
-		: Position(px, py, pz), Texture(tx, ty), Normal(nx, ny, nz) {}
+	Vertex(GLfloat px, GLfloat py, GLfloat pz, GLfloat tx, GLfloat ty, GLfloat tl, GLfloat nx, GLfloat ny, GLfloat nz)
+		: Position(px, py, pz), Texture(tx, ty, tl), Normal(nx, ny, nz) {}
 
 	Vertex(const GLfloat* data)
 	{
 		Position = glm::vec3(data[0], data[1], data[2]);
-		Texture = glm::vec2(data[3], data[4]);
-		Normal = glm::vec3(data[5], data[6], data[7]);
+		Texture = glm::vec3(data[3], data[4], data[5]);
+		Normal = glm::vec3(data[6], data[7], data[8]);
+	}
+
+	static GLuint PackColor(const glm::vec3& color)
+	{
+		const glm::uvec3 bytes = glm::uvec3(glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f);
+		return bytes.r | (bytes.g << 8) | (bytes.b << 16) | (255u << 24);
 	}
 
 	const GLfloat* GetData() const
@@ -32,7 +40,7 @@ struct Vertex
 	std::vector<GLfloat> GetRaw() const
 	{
 		std::vector<GLfloat> raw;
-		raw.reserve(8);
+		raw.reserve(9);
 
 		raw.emplace_back(Position.x);
 		raw.emplace_back(Position.y);
@@ -40,6 +48,7 @@ struct Vertex
 
 		raw.emplace_back(Texture.x);
 		raw.emplace_back(Texture.y);
+		raw.emplace_back(Texture.z);
 
 		raw.emplace_back(Normal.x);
 		raw.emplace_back(Normal.y);
@@ -1,22 +1,39 @@
 #include "World.h"
+#include "ChunkPool.h"
+#include "LightEngine.h"
 
-World::World(unsigned chunkSize) : ChunkSize(chunkSize), LastPlayerChunkPos(INT_MAX)
+#include "glm/gtc/constants.hpp"
+#include <filesystem>
+#include <limits>
+
+World::World() : LastPlayerChunkPos(INT_MAX)
 {
+	// Chunks are unloaded past twice the draw distance, one extra ring covers the frame before that.
+	Chunks.Init(static_cast<int>(GetDrawDistance()) * 2 + 1);
 }
 
-void World::Update(const glm::vec3& playerPos)
+void World::Update(const glm::vec3& playerPos, const glm::vec3& playerVelocity)
 {
 	AddReadyChunks();
 
 	glm::vec2 playerChunkPos = World2ChunkCoords(playerPos);
 	if (playerChunkPos != LastPlayerChunkPos)
 	{
-		UnloadDistantChunks(playerChunkPos);
-		LoadChunks(playerChunkPos);
+		UpdateLoadedChunks(playerChunkPos);
 		LastPlayerChunkPos = playerChunkPos;
 	}
 
+	const LoadRegion region = GetLoadRegion(playerChunkPos, playerVelocity);
+	if (region != LoadedRegion)
+	{
+		LoadChunks(region, playerChunkPos);
+	}
+	RetryBlockedLoads(playerChunkPos);
+
+	ProcessEdits();
+	ProcessMeshRequests();
 	ProcessChunkQueue();
+	FinishEdits();
 	CleanupFinishedFutures();
 }
 
@@ -26,15 +43,38 @@ void World::AddReadyChunks()
 	int processed = 0;
 	while (processed < maxChunksPerFrame)
 	{
-		if (Chunk* const chunk = ChunksGenerated.tryPop())
+		Chunk* const chunk = ChunksGenerated.tryPop();
+		if (!chunk)
+		{
+			break;
+		}
+
+		const std::pair<int, int> key = chunk->getKey();
+		if (chunk->MeshQueued)
 		{
 			chunk->GenerateOpenGLData();
-			Chunks.emplace(chunk->getKey(), chunk);
+			chunk->MeshQueued = false;
+			RequestMesh(key);
 			processed++;
 		}
 		else
 		{
-			break;
+			ChunkSlot& slot = Chunks.At(key);
+			if (slot.Key != key || !slot.Waiting)
+			{
+				// The slot was handed over while generating, it gets requested again if still needed.
+				ChunkPool::ReleaseChunk(chunk);
+				continue;
+			}
+
+			// Fresh blocks, the chunk and its neighbours may be meshable now.
+			slot.chunk = chunk;
+			slot.Waiting = false;
+			RequestMesh(key);
+			for (int side = Side::FRONT; side <= Side::RIGHT; ++side)
+			{
+				RequestMesh(GetNeighbourKey(key, static_cast<Side>(side)));
+			}
 		}
 	}
 }
@@ -44,75 +84,1449 @@ void World::ProcessChunkQueue()
 	while (CurrentTasksCount < MaxTasks && !ChunksToGenerate.empty()) {
 		ChunkTask task = ChunksToGenerate.top();
 		ChunksToGenerate.pop();
+		LaunchTask(task);
+	}
+}
 
-		CurrentTasksCount++;
-		Futures.emplace_back(std::async(std::launch::async, [this, task]() {
-			Chunk* const chunk = new Chunk({ task.key.first, task.key.second });
-			chunk->GenerateData();
-			ChunksGenerated.push(chunk);
-			CurrentTasksCount--;
+void World::LaunchTask(const ChunkTask& task)
+{
+	std::atomic<int>& taskCount = task.urgent ? CurrentEditTasksCount : CurrentTasksCount;
+	taskCount++;
+	std::vector<std::future<void>>& futures = task.urgent ? EditFutures : Futures;
+	const std::string savePath = task.chunk ? std::string() : GetSavePath(task.key);
+	futures.emplace_back(std::async(std::launch::async, [this, task, &taskCount, savePath]() {
+			Chunk* chunk = task.chunk;
+			if (chunk)
+			{
+				chunk->GenerateMesh(task.lod, task.neighbours, task.bakeLight);
+				for (Chunk* const neighbour : task.neighbours)
+				{
+					if (neighbour)
+					{
+						neighbour->Unpin();
+					}
+				}
+			}
+			else
+			{
+				chunk = ChunkPool::AcquireChunk({ task.key.first, task.key.second });
+				chunk->GenerateData(savePath);
+			}
+			(task.urgent ? ChunksRemeshed : ChunksGenerated).push(chunk);
+			taskCount--;
 			}));
+}
+
+void World::RequestLight(const std::pair<int, int>& key)
+{
+	ChunkSlot* const slot = Chunks.Find(key);
+	if (slot && slot->chunk && !slot->LightRequested)
+	{
+		slot->LightRequested = true;
+		ChunksToLight.emplace_back(key);
+	}
+}
+
+void World::ProcessLightRequests()
+{
+	ChunksToLight.erase(
+		std::remove_if(ChunksToLight.begin(), ChunksToLight.end(),
+			[this](const std::pair<int, int>& key) {
+				if (!LaunchLightTask(key))
+				{
+					return false;
+				}
+				if (ChunkSlot* const slot = Chunks.Find(key))
+				{
+					slot->LightRequested = false;
+				}
+				return true;
+			}),
+		ChunksToLight.end());
+}
+
+bool World::LaunchLightTask(const std::pair<int, int>& key)
+{
+	ChunkSlot* const slot = Chunks.Find(key);
+	Chunk* const chunk = slot ? slot->chunk : nullptr;
+	if (!chunk)
+	{
+		return true;
+	}
+	if (chunk->LightQueued || chunk->MeshQueued || chunk->IsPinned())
+	{
+		return false;
+	}
+	if (chunk->GetLightStage() == LIGHT_LINKED && slot->LightEdits.empty())
+	{
+		return true;
+	}
+
+	// Edits share their meshes' budget.
+	const bool urgent = !slot->LightEdits.empty();
+	std::atomic<int>& taskCount = urgent ? CurrentEditTasksCount : CurrentTasksCount;
+	if (taskCount >= (urgent ? MaxEditTasks : MaxTasks))
+	{
+		return false;
+	}
+
+	// Lit neighbours are written to, so none of them may be read by anyone else. The whole
+	// neighbourhood is held, so overlapping tasks never run at the same time.
+	std::array<Chunk*, 9> held{};
+	LightNeighbourhood chunks{};
+	for (int dx = -1; dx <= 1; ++dx)
+	{
+		for (int dz = -1; dz <= 1; ++dz)
+		{
+			Chunk* const neighbour = Chunks.Get({ key.first + dx, key.second + dz });
+			if (!neighbour)
+			{
+				continue;
+			}
+			if (neighbour->LightQueued || neighbour->MeshQueued || neighbour->IsPinned())
+			{
+				return false;
+			}
+			held[(dx + 1) * 3 + (dz + 1)] = neighbour;
+			if (!neighbour->IsCompressed() && neighbour->GetLightStage() != LIGHT_NONE)
+			{
+				chunks[(dx + 1) * 3 + (dz + 1)] = neighbour;
+			}
+		}
+	}
+	chunks[LightEngine::CenterChunk] = chunk;
+
+	if (chunk->IsCompressed())
+	{
+		chunk->Decompress();
+	}
+	for (Chunk* const neighbour : held)
+	{
+		if (neighbour)
+		{
+			neighbour->LightQueued = true;
+		}
+	}
+
+	std::vector<glm::ivec3> edits;
+	edits.swap(slot->LightEdits);
+	// Never waited on, the GL thread picks the result up whenever it is ready.
+	taskCount++;
+	Futures.emplace_back(std::async(std::launch::async, [this, chunk, chunks, edits = std::move(edits), urgent, &taskCount]() {
+			// A chunk lit from scratch already has its edits.
+			if (chunk->GetLightStage() == LIGHT_NONE)
+			{
+				LightEngine::LightChunk(*chunk);
+			}
+			else if (!edits.empty())
+			{
+				LightEngine::Update(chunks, edits);
+			}
+			if (chunk->GetLightStage() != LIGHT_LINKED)
+			{
+				LightEngine::Link(chunks);
+				chunk->SetLightStage(LIGHT_LINKED);
+			}
+			(urgent ? ChunksRelit : ChunksLinked).push(chunk);
+			taskCount--;
+			}));
+	return true;
+}
+
+void World::FinishLightTask(Chunk* chunk, bool urgent)
+{
+	// Chunks holding LightQueued are never unloaded, the neighbourhood is found again by key.
+	const std::pair<int, int> key = chunk->getKey();
+	for (int dx = -1; dx <= 1; ++dx)
+	{
+		for (int dz = -1; dz <= 1; ++dz)
+		{
+			const std::pair<int, int> neighbourKey = { key.first + dx, key.second + dz };
+			Chunk* const neighbour = Chunks.Get(neighbourKey);
+			if (!neighbour || !neighbour->LightQueued)
+			{
+				continue;
+			}
+
+			neighbour->LightQueued = false;
+			if (!LightVolumes && !neighbour->IsCompressed())
+			{
+				neighbour->BakeLightChanges();
+			}
+			if (!neighbour->IsCompressed() && neighbour->IsDirty())
+			{
+				if (urgent)
+				{
+					RequestEditMesh(neighbourKey);
+				}
+				else
+				{
+					RequestMesh(neighbourKey);
+				}
+			}
+		}
+	}
+}
+
+void World::UpdateLightVolume(const std::pair<int, int>& key, Chunk* chunk)
+{
+	if (chunk->LightQueued)
+	{
+		return;
+	}
+
+	std::array<const Chunk*, 9> neighbours{};
+	for (int dx = -1; dx <= 1; ++dx)
+	{
+		for (int dz = -1; dz <= 1; ++dz)
+		{
+			const Chunk* const neighbour = Chunks.Get({ key.first + dx, key.second + dz });
+			if (neighbour && neighbour->LightQueued)
+			{
+				return;
+			}
+			neighbours[(dx + 1) * 3 + (dz + 1)] = neighbour;
+		}
 	}
+	chunk->UpdateLightVolume(neighbours);
 }
 
 void World::Render(const ShaderProgram& shader, const Camera& camera, const glm::mat4& proj)
 {
-	for (auto& [key, chunk] : Chunks)
+	const bool culled = CaveCulling && FindVisibleSections(camera);
+	Stats = CullingStats{};
+	if (OcclusionCulling)
+	{
+		BuildOccluders(camera, proj);
+		Stats.occluders = Occlusion.GetOccluderCount();
+	}
+
+	// The light volume sampler keeps its own unit even when unused, two sampler types can't share one.
+	shader.Bind();
+	shader.BindUniform1i("lightVolume", Chunk::LightVolumeUnit);
+	shader.BindUniform1i("useLightVolume", false);
+	const GLint useLightVolume = LightVolumes ? shader.GetUniformLocation("useLightVolume") : -1;
+
+	// Nearest chunks first, so the depth test rejects what they hide before it is shaded.
+	SortDrawOrder(camera.pos);
+	const std::vector<ChunkSlot>& slots = Chunks.GetSlots();
+	for (const DrawEntry& entry : DrawOrder)
+	{
+		const size_t index = entry.slot;
+		const ChunkSlot& slot = slots[index];
+		if (!slot.chunk)
+		{
+			break;
+		}
+		if (!slot.chunk->HasMesh())
+		{
+			continue;
+		}
+
+		const unsigned sections = (culled ? VisibleSections[index] : Chunk::AllSections) & slot.chunk->GetDrawMask();
+		if (sections == 0)
+		{
+			continue;
+		}
+		if (OcclusionCulling && IsChunkOccluded(slot.Key, sections))
+		{
+			++Stats.occluded;
+			continue;
+		}
+
+		// Full detail meshes hold no light of their own, they wait for their light volume.
+		if (LightVolumes && slot.chunk->GetLod() == 0)
+		{
+			UpdateLightVolume(slot.Key, slot.chunk);
+			if (!slot.chunk->HasLightVolume())
+			{
+				continue;
+			}
+		}
+		slot.chunk->Render(shader, camera, proj, sections, SideCulling, useLightVolume);
+		++Stats.drawn;
+	}
+}
+
+const CullingStats& World::GetCullingStats() const
+{
+	return Stats;
+}
+
+void World::PrintCullingStats() const
+{
+	std::cout << "[CULLING]: " << Stats.drawn << " chunks drawn, " << Stats.occluded << " occluded, "
+		<< Stats.occluders << " occluder quads\n";
+}
+
+bool World::FindVisibleSections(const Camera& camera)
+{
+	const int size = static_cast<int>(ChunkSize);
+	const int sectionSize = static_cast<int>(ChunkSection::Size);
+	const glm::ivec3 block = glm::ivec3(glm::floor(camera.pos + 0.5f));
+	if (block.y < 0 || block.y >= static_cast<int>(Chunk::SectionCount) * sectionSize)
+	{
+		return false;
+	}
+
+	const std::pair<int, int> startKey = GetChunkKey(block);
+	const Chunk* const start = Chunks.Get(startKey);
+	if (!start || !start->HasMesh())
+	{
+		return false;
+	}
+
+	const std::vector<ChunkSlot>& slots = Chunks.GetSlots();
+	VisibleSections.assign(slots.size(), 0u);
+	SectionQueue.clear();
+	SectionQueue.push_back({ startKey, Chunks.GetSlotIndex(startKey), static_cast<unsigned>(block.y / sectionSize) });
+	VisibleSections[SectionQueue.front().slot] |= 1u << SectionQueue.front().index;
+
+	// Sections entirely behind the camera can't be seen, whatever connects them.
+	const glm::vec3 forward = glm::normalize(camera.front);
+	const float sectionRadius = sectionSize * 0.5f * std::sqrt(3.0f);
+
+	for (size_t next{}; next < SectionQueue.size(); ++next)
+	{
+		const SectionVisit visit = SectionQueue[next];
+		const Chunk* const chunk = slots[visit.slot].chunk;
+		for (unsigned side{}; side < 6; ++side)
+		{
+			// Sides pair up as FRONT/BACK, LEFT/RIGHT and BOTTOM/TOP.
+			const Side to = static_cast<Side>(side);
+			const Side back = static_cast<Side>(side ^ 1u);
+			if ((visit.directions & (1u << back)) ||
+				(visit.from >= 0 && !chunk->CanSeeThrough(visit.index, static_cast<Side>(visit.from), to)))
+			{
+				continue;
+			}
+
+			SectionVisit step{ visit.key, visit.slot, visit.index, back, visit.directions | (1u << to) };
+			if (to == Side::BOTTOM || to == Side::TOP)
+			{
+				if ((to == Side::BOTTOM && visit.index == 0) || (to == Side::TOP && visit.index + 1 == Chunk::SectionCount))
+				{
+					continue;
+				}
+				step.index = to == Side::TOP ? visit.index + 1 : visit.index - 1;
+			}
+			else
+			{
+				step.key = GetNeighbourKey(visit.key, to);
+				step.slot = Chunks.GetSlotIndex(step.key);
+				const ChunkSlot& slot = slots[step.slot];
+				if (slot.Key != step.key || !slot.chunk || !slot.chunk->HasMesh())
+				{
+					continue;
+				}
+			}
+
+			unsigned& visible = VisibleSections[step.slot];
+			if (visible & (1u << step.index))
+			{
+				continue;
+			}
+
+			const glm::vec3 centre(step.key.first * size + (size - 1) * 0.5f, step.index * sectionSize + (sectionSize - 1) * 0.5f,
+				step.key.second * size + (size - 1) * 0.5f);
+			if (glm::dot(centre - camera.pos, forward) < -sectionRadius)
+			{
+				continue;
+			}
+
+			visible |= 1u << step.index;
+			SectionQueue.push_back(step);
+		}
+	}
+	return true;
+}
+
+void World::SortDrawOrder(const glm::vec3& eye)
+{
+	const std::vector<ChunkSlot>& slots = Chunks.GetSlots();
+	if (DrawOrder.size() != slots.size())
+	{
+		DrawOrder.resize(slots.size());
+		for (size_t index{}; index < DrawOrder.size(); ++index)
+		{
+			DrawOrder[index].slot = index;
+		}
+	}
+
+	const float size = static_cast<float>(ChunkSize);
+	for (DrawEntry& entry : DrawOrder)
+	{
+		const ChunkSlot& slot = slots[entry.slot];
+		if (!slot.chunk)
+		{
+			entry.distance = std::numeric_limits<float>::max();
+			continue;
+		}
+		const glm::vec2 offset(slot.Key.first * size + (size - 1.0f) * 0.5f - eye.x, slot.Key.second * size + (size - 1.0f) * 0.5f - eye.z);
+		entry.distance = glm::dot(offset, offset);
+	}
+
+	// Last frame's order is close when the camera moved a little and insertion sort is then
+	// about linear. After a big change, like a teleport or a burst of loads, it gives up for std::sort.
+	const size_t maxMoves = DrawOrder.size() * 4;
+	size_t moves = 0;
+	for (size_t index = 1; index < DrawOrder.size(); ++index)
 	{
-		chunk->Render(shader, camera, proj);
+		const DrawEntry entry = DrawOrder[index];
+		size_t target = index;
+		while (target > 0 && DrawOrder[target - 1].distance > entry.distance)
+		{
+			DrawOrder[target] = DrawOrder[target - 1];
+			--target;
+		}
+		DrawOrder[target] = entry;
+
+		moves += index - target;
+		if (moves > maxMoves)
+		{
+			std::sort(DrawOrder.begin(), DrawOrder.end(), [](const DrawEntry& a, const DrawEntry& b) {
+				return a.distance < b.distance;
+				});
+			break;
+		}
 	}
 }
 
+void World::BuildOccluders(const Camera& camera, const glm::mat4& proj)
+{
+	Occlusion.Begin(proj * camera.view);
+
+	// The solid base of the terrain is a height field over occluder cells, its tops and the
+	// parts of its sides that rise above the next cell are drawn where they face the camera.
+	// Blocks are centred on integer coordinates, so the surfaces run along their outer faces.
+	const int size = static_cast<int>(ChunkSize);
+	const int cell = static_cast<int>(Chunk::OccluderCell);
+	const int cellsX = static_cast<int>(Chunk::SizeX / Chunk::OccluderCell);
+	const int cellsZ = static_cast<int>(Chunk::SizeZ / Chunk::OccluderCell);
+	const std::pair<int, int> centre = GetChunkKey(glm::ivec3(glm::floor(camera.pos + 0.5f)));
+	const auto heightAt = [this](const std::pair<int, int>& key, int cellX, int cellZ) -> float {
+		const std::pair<int, int> owner(key.first + (cellX < 0 ? -1 : cellX >= cellsX ? 1 : 0), key.second + (cellZ < 0 ? -1 : cellZ >= cellsZ ? 1 : 0));
+		const Chunk* const chunk = Chunks.Get(owner);
+		if (!chunk || !chunk->HasMesh())
+		{
+			return 0.0f;
+		}
+		return chunk->GetOccluderHeights()[((cellX + cellsX) % cellsX) * cellsZ + (cellZ + cellsZ) % cellsZ];
+		};
+
+	for (int dz = -OccluderRadius; dz <= OccluderRadius; ++dz)
+	{
+		for (int dx = -OccluderRadius; dx <= OccluderRadius; ++dx)
+		{
+			const std::pair<int, int> key(centre.first + dx, centre.second + dz);
+			const Chunk* const chunk = Chunks.Get(key);
+			if (!chunk || !chunk->HasMesh())
+			{
+				continue;
+			}
+
+			const std::array<uint16_t, Chunk::OccluderCells>& heights = chunk->GetOccluderHeights();
+			for (int cellX{}; cellX < cellsX; ++cellX)
+			{
+				for (int cellZ{}; cellZ < cellsZ; ++cellZ)
+				{
+					const float height = heights[cellX * cellsZ + cellZ];
+					if (height == 0.0f)
+					{
+						continue;
+					}
+
+					const float x0 = key.first * size + cellX * cell - 0.5f;
+					const float z0 = key.second * size + cellZ * cell - 0.5f;
+					const float x1 = x0 + cell;
+					const float z1 = z0 + cell;
+					const float top = height - 0.5f;
+					if (camera.pos.y > top)
+					{
+						Occlusion.AddOccluder({ x0, top, z0 }, { x1, top, z0 }, { x1, top, z1 }, { x0, top, z1 });
+					}
+
+					// Sides, only above the neighbouring cell.
+					if (camera.pos.x < x0 && heightAt(key, cellX - 1, cellZ) < height)
+					{
+						const float bottom = heightAt(key, cellX - 1, cellZ) - 0.5f;
+						Occlusion.AddOccluder({ x0, bottom, z0 }, { x0, top, z0 }, { x0, top, z1 }, { x0, bottom, z1 });
+					}
+					if (camera.pos.x > x1 && heightAt(key, cellX + 1, cellZ) < height)
+					{
+						const float bottom = heightAt(key, cellX + 1, cellZ) - 0.5f;
+						Occlusion.AddOccluder({ x1, bottom, z0 }, { x1, top, z0 }, { x1, top, z1 }, { x1, bottom, z1 });
+					}
+					if (camera.pos.z < z0 && heightAt(key, cellX, cellZ - 1) < height)
+					{
+						const float bottom = heightAt(key, cellX, cellZ - 1) - 0.5f;
+						Occlusion.AddOccluder({ x0, bottom, z0 }, { x0, top, z0 }, { x1, top, z0 }, { x1, bottom, z0 });
+					}
+					if (camera.pos.z > z1 && heightAt(key, cellX, cellZ + 1) < height)
+					{
+						const float bottom = heightAt(key, cellX, cellZ + 1) - 0.5f;
+						Occlusion.AddOccluder({ x0, bottom, z1 }, { x0, top, z1 }, { x1, top, z1 }, { x1, bottom, z1 });
+					}
+				}
+			}
+		}
+	}
+	Occlusion.Finish();
+}
+
+bool World::IsChunkOccluded(const std::pair<int, int>& key, unsigned sections) const
+{
+	// Bounds of the sections that would be drawn.
+	const float size = static_cast<float>(ChunkSize);
+	const float sectionSize = static_cast<float>(ChunkSection::Size);
+	const unsigned lowest = std::countr_zero(sections);
+	const unsigned highest = 31u - std::countl_zero(sections);
+	const glm::vec3 min(key.first * size - 0.5f, lowest * sectionSize - 0.5f, key.second * size - 0.5f);
+	const glm::vec3 max(min.x + size, (highest + 1) * sectionSize - 0.5f, min.z + size);
+	return Occlusion.IsOccluded(min, max);
+}
+
 void World::Delete()
 {
-	for (auto& [key, chunk] : Chunks)
+	// Workers still hold chunks, every task has to be done before anything is freed.
+	for (std::vector<std::future<void>>* futures : { &Futures, &EditFutures })
+	{
+		for (std::future<void>& future : *futures)
+		{
+			future.wait();
+		}
+		futures->clear();
+	}
+
+	// Remeshed chunks are owned by Chunks already.
+	while (Chunk* const chunk = ChunksGenerated.tryPop())
+	{
+		if (!chunk->MeshQueued)
+		{
+			delete chunk;
+		}
+	}
+	while (ChunksRemeshed.tryPop() || ChunksLinked.tryPop() || ChunksRelit.tryPop())
+	{
+	}
+
+	for (ChunkSlot& slot : Chunks.GetSlots())
+	{
+		if (slot.chunk)
+		{
+			if (slot.chunk->HasUnsavedEdits())
+			{
+				SaveChunk(slot.Key, slot.chunk);
+			}
+			slot.chunk->Delete();
+			delete slot.chunk;
+		}
+		slot = ChunkSlot{};
+	}
+	ChunksToMesh.clear();
+	ChunksEdited.clear();
+	ChunksToLight.clear();
+	BlockedLoads.clear();
+	LoadedRegion = LoadRegion{};
+}
+
+CubeType World::GetBlock(const glm::ivec3& position) const
+{
+	if (position.y < 0 || position.y >= static_cast<int>(Chunk::SectionCount * ChunkSection::Size))
+	{
+		return CubeType::EMPTY;
+	}
+
+	const std::pair<int, int> key = GetChunkKey(position);
+	const Chunk* const chunk = Chunks.Get(key);
+	if (!chunk)
+	{
+		return CubeType::EMPTY;
+	}
+
+	const int size = static_cast<int>(ChunkSize);
+	return chunk->GetBlock(position.x - key.first * size, position.y, position.z - key.second * size);
+}
+
+bool World::SetBlock(const glm::ivec3& position, CubeType type)
+{
+	if (position.y < 0 || position.y >= static_cast<int>(Chunk::SectionCount * ChunkSection::Size) ||
+		!Chunks.Get(GetChunkKey(position)))
+	{
+		return false;
+	}
+
+	// Chunks that workers are reading take the edit once they are released.
+	const BlockEdit edit{ position, type };
+	if (!ApplyEdit(edit))
 	{
-		chunk->Delete();
-		delete chunk;
+		PendingEdits.emplace_back(edit);
 	}
-	Chunks.clear();
+	return true;
+}
+
+RaycastHit World::Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const
+{
+	RaycastHit result;
+	const glm::vec3 dir = glm::normalize(direction);
+	const int height = static_cast<int>(Chunk::SectionCount * ChunkSection::Size);
+	const int size = static_cast<int>(ChunkSize);
+
+	// Blocks are centred on integer coordinates, so cell boundaries sit on half units.
+	const glm::vec3 start = origin + 0.5f;
+	glm::ivec3 block = glm::ivec3(glm::floor(start));
+	glm::ivec3 step(0);
+	glm::vec3 tDelta(std::numeric_limits<float>::infinity());
+	glm::vec3 tMax(std::numeric_limits<float>::infinity());
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (dir[axis] > 0.0f)
+		{
+			step[axis] = 1;
+			tDelta[axis] = 1.0f / dir[axis];
+			tMax[axis] = (block[axis] + 1 - start[axis]) * tDelta[axis];
+		}
+		else if (dir[axis] < 0.0f)
+		{
+			step[axis] = -1;
+			tDelta[axis] = -1.0f / dir[axis];
+			tMax[axis] = (start[axis] - block[axis]) * tDelta[axis];
+		}
+	}
+
+	// The chunk is only looked up again when the ray crosses into another one.
+	std::pair<int, int> chunkKey = GetChunkKey(block);
+	const Chunk* chunk = FindChunk(chunkKey);
+	float distance = 0.0f;
+	int lastAxis = -1;
+	while (distance <= maxDistance)
+	{
+		if (block.y >= 0 && block.y < height)
+		{
+			const std::pair<int, int> key = GetChunkKey(block);
+			if (key != chunkKey)
+			{
+				chunkKey = key;
+				chunk = FindChunk(key);
+			}
+
+			if (chunk)
+			{
+				const CubeType type = chunk->GetBlock(block.x - key.first * size, block.y, block.z - key.second * size);
+				if (BlockRegistry::IsSolid(type))
+				{
+					result.hit = true;
+					result.block = block;
+					result.distance = distance;
+					result.type = type;
+					if (lastAxis >= 0)
+					{
+						result.normal[lastAxis] = -step[lastAxis];
+						static constexpr Side negativeFaces[3] = { Side::LEFT, Side::BOTTOM, Side::BACK };
+						static constexpr Side positiveFaces[3] = { Side::RIGHT, Side::TOP, Side::FRONT };
+						result.face = step[lastAxis] > 0 ? negativeFaces[lastAxis] : positiveFaces[lastAxis];
+					}
+					return result;
+				}
+			}
+		}
+		else if ((block.y < 0 && step.y <= 0) || (block.y >= height && step.y >= 0))
+		{
+			// Left the world vertically and never coming back.
+			break;
+		}
+
+		lastAxis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+		distance = tMax[lastAxis];
+		block[lastAxis] += step[lastAxis];
+		tMax[lastAxis] += tDelta[lastAxis];
+	}
+
+	return result;
+}
+
+double World::BenchmarkRaycast(const glm::vec3& origin, unsigned rayCount, float maxDistance) const
+{
+	// Fibonacci sphere so every run casts the same well spread directions.
+	const float goldenAngle = glm::pi<float>() * (3.0f - std::sqrt(5.0f));
+	unsigned hits = 0;
+	float totalDistance = 0.0f;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned i = 0; i < rayCount; ++i)
+	{
+		const float y = 1.0f - 2.0f * (i + 0.5f) / rayCount;
+		const float radius = std::sqrt(1.0f - y * y);
+		const float angle = goldenAngle * i;
+		const RaycastHit hit = Raycast(origin, glm::vec3(std::cos(angle) * radius, y, std::sin(angle) * radius), maxDistance);
+		if (hit.hit)
+		{
+			++hits;
+			totalDistance += hit.distance;
+		}
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+	const double raysPerSecond = rayCount / std::max(elapsed.count(), 1e-9);
+	std::cout << "[RAYCAST]: " << rayCount << " rays in " << elapsed.count() * 1000.0 << " ms, "
+		<< raysPerSecond << " rays/s, " << hits << " hits, avg distance "
+		<< (hits ? totalDistance / hits : 0.0f) << "\n";
+	return raysPerSecond;
+}
+
+double World::BenchmarkMeshing(unsigned passes)
+{
+	// Chunks no worker is touching are remeshed in place against their current neighbours,
+	// which no worker may be touching either. Those are pinned like for a mesh task.
+	const auto isBusy = [](const Chunk* chunk) {
+		return chunk->MeshQueued || chunk->LightQueued || chunk->IsPinned();
+		};
+	std::vector<std::pair<Chunk*, std::array<Chunk*, 4>>> chunks;
+	for (const ChunkSlot& slot : Chunks.GetSlots())
+	{
+		Chunk* const chunk = slot.chunk;
+		if (slot.IsFree() || !chunk || isBusy(chunk) || chunk->IsCompressed() || !chunk->HasMesh() || chunk->GetLod() != 0)
+		{
+			continue;
+		}
+
+		std::array<Chunk*, 4> neighbours{};
+		bool idle = true;
+		for (int side = Side::FRONT; side <= Side::RIGHT && idle; ++side)
+		{
+			if (chunk->GetNeighbourMask() & (1u << side))
+			{
+				neighbours[side] = Chunks.Get(GetNeighbourKey(slot.Key, static_cast<Side>(side)));
+				idle = !neighbours[side] || !isBusy(neighbours[side]);
+			}
+		}
+		if (idle)
+		{
+			chunks.emplace_back(chunk, neighbours);
+		}
+	}
+
+	if (chunks.empty())
+	{
+		std::cout << "[MESHING]: no idle full detail chunks\n";
+		return 0.0;
+	}
+
+	for (auto& [chunk, neighbours] : chunks)
+	{
+		for (Chunk* const neighbour : neighbours)
+		{
+			if (neighbour)
+			{
+				neighbour->Pin();
+			}
+		}
+	}
+
+	// The old per block neighbour lookups first, so the meshes left behind are the current ones.
+	const auto time = [this, &chunks, passes](bool perBlockLookup) {
+		auto start = std::chrono::high_resolution_clock::now();
+		for (unsigned pass{}; pass < passes; ++pass)
+		{
+			for (auto& [chunk, neighbours] : chunks)
+			{
+				chunk->MarkDirty();
+				chunk->GenerateMesh(0, neighbours, !LightVolumes, perBlockLookup);
+			}
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		return elapsed.count();
+		};
+	const double perBlockSeconds = time(true);
+	const double seconds = time(false);
+
+	for (auto& [chunk, neighbours] : chunks)
+	{
+		for (Chunk* const neighbour : neighbours)
+		{
+			if (neighbour)
+			{
+				neighbour->Unpin();
+			}
+		}
+		chunk->GenerateOpenGLData();
+	}
+
+	const size_t meshed = chunks.size() * passes;
+	const double chunksPerSecond = meshed / std::max(seconds, 1e-9);
+	std::cout << "[MESHING]: " << meshed << " chunks in " << seconds * 1000.0 << " ms, "
+		<< chunksPerSecond << " chunks/s, " << seconds * 1e6 / meshed << " us per chunk, per block lookups "
+		<< perBlockSeconds * 1e6 / meshed << " us per chunk\n";
+	return chunksPerSecond;
+}
+
+// Layout benchmark kernels over one section, cells outside it count as air.
+template <typename Blocks>
+static unsigned CountFaces(const Blocks& blocks)
+{
+	constexpr int size = static_cast<int>(Blocks::SizeX);
+	const auto opaqueAt = [&blocks](int x, int y, int z) {
+		return x >= 0 && x < size && y >= 0 && y < size && z >= 0 && z < size && BlockRegistry::IsOpaque(blocks.at(x, y, z));
+		};
+
+	unsigned faces = 0;
+	for (int x{}; x < size; ++x)
+	{
+		for (int y{}; y < size; ++y)
+		{
+			for (int z{}; z < size; ++z)
+			{
+				if (BlockRegistry::IsVisible(blocks.at(x, y, z)))
+				{
+					faces += !opaqueAt(x + 1, y, z) + !opaqueAt(x - 1, y, z)
+						+ !opaqueAt(x, y + 1, z) + !opaqueAt(x, y - 1, z)
+						+ !opaqueAt(x, y, z + 1) + !opaqueAt(x, y, z - 1);
+				}
+			}
+		}
+	}
+	return faces;
+}
+
+// Breadth first flood of the see-through cells reachable from the top face, as sky light would spread.
+template <typename Blocks, typename Visited>
+static unsigned FloodFill(const Blocks& blocks, Visited& visited, std::vector<glm::ivec3>& queue)
+{
+	constexpr int size = static_cast<int>(Blocks::SizeX);
+	std::fill_n(visited.data(), Visited::Volume, uint8_t(0));
+	queue.clear();
+
+	const auto push = [&blocks, &visited, &queue](int x, int y, int z) {
+		if (x >= 0 && x < size && y >= 0 && y < size && z >= 0 && z < size
+			&& !visited.at(x, y, z) && !BlockRegistry::IsOpaque(blocks.at(x, y, z)))
+		{
+			visited.at(x, y, z) = 1;
+			queue.emplace_back(x, y, z);
+		}
+		};
+
+	for (int x{}; x < size; ++x)
+	{
+		for (int z{}; z < size; ++z)
+		{
+			push(x, size - 1, z);
+		}
+	}
+	for (size_t next{}; next < queue.size(); ++next)
+	{
+		const glm::ivec3 cell = queue[next];
+		push(cell.x + 1, cell.y, cell.z);
+		push(cell.x - 1, cell.y, cell.z);
+		push(cell.x, cell.y + 1, cell.z);
+		push(cell.x, cell.y - 1, cell.z);
+		push(cell.x, cell.y, cell.z + 1);
+		push(cell.x, cell.y, cell.z - 1);
+	}
+	return static_cast<unsigned>(queue.size());
+}
+
+template <template <unsigned, unsigned, unsigned> class Layout>
+static void BenchmarkLayout(const char* name, const std::vector<CubeType>& sections, unsigned passes)
+{
+	constexpr unsigned size = ChunkSection::Size;
+	using Blocks = FixedArray3D<CubeType, size, size, size, Layout>;
+	const size_t count = sections.size() / Blocks::Volume;
+
+	// Sections are stored x, y, z with z fastest, reordered into the layout.
+	std::vector<Blocks> arrays(count);
+	for (size_t i{}; i < count; ++i)
+	{
+		arrays[i].Init();
+		const CubeType* source = &sections[i * Blocks::Volume];
+		for (unsigned x{}; x < size; ++x)
+		{
+			for (unsigned y{}; y < size; ++y)
+			{
+				for (unsigned z{}; z < size; ++z)
+				{
+					arrays[i].at(x, y, z) = *source++;
+				}
+			}
+		}
+	}
+
+	unsigned faces = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for (unsigned pass{}; pass < passes; ++pass)
+	{
+		for (const Blocks& blocks : arrays)
+		{
+			faces += CountFaces(blocks);
+		}
+	}
+	const std::chrono::duration<double> facesElapsed = std::chrono::high_resolution_clock::now() - start;
+
+	FixedArray3D<uint8_t, size, size, size, Layout> visited;
+	visited.Init();
+	std::vector<glm::ivec3> queue;
+	queue.reserve(Blocks::Volume);
+	unsigned flooded = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (unsigned pass{}; pass < passes; ++pass)
+	{
+		for (const Blocks& blocks : arrays)
+		{
+			flooded += FloodFill(blocks, visited, queue);
+		}
+	}
+	const std::chrono::duration<double> floodElapsed = std::chrono::high_resolution_clock::now() - start;
+
+	const double sectionCount = static_cast<double>(count) * passes;
+	std::cout << "[LAYOUT]: " << name << " faces " << facesElapsed.count() * 1e6 / sectionCount << " us per section ("
+		<< faces / passes << "), flood fill " << floodElapsed.count() * 1e6 / sectionCount << " us per section ("
+		<< flooded / passes << ")\n";
+}
+
+void World::BenchmarkLayouts(unsigned passes) const
+{
+	// Every non-empty section of the loaded chunks, copied out so all layouts see the same blocks.
+	constexpr unsigned size = ChunkSection::Size;
+	std::vector<CubeType> sections;
+	std::vector<CubeType> blocks(size * size * size);
+	for (const ChunkSlot& slot : Chunks.GetSlots())
+	{
+		const Chunk* const chunk = slot.chunk;
+		if (slot.IsFree() || chunk->MeshQueued || chunk->IsCompressed())
+		{
+			continue;
+		}
+
+		for (unsigned index{}; index < Chunk::SectionCount; ++index)
+		{
+			bool empty = true;
+			CubeType* block = blocks.data();
+			for (unsigned x{}; x < size; ++x)
+			{
+				for (unsigned y{}; y < size; ++y)
+				{
+					for (unsigned z{}; z < size; ++z)
+					{
+						*block = chunk->GetBlock(x, index * size + y, z);
+						empty = empty && *block == CubeType::EMPTY;
+						++block;
+					}
+				}
+			}
+			if (!empty)
+			{
+				sections.insert(sections.end(), blocks.begin(), blocks.end());
+			}
+		}
+	}
+
+	if (sections.empty())
+	{
+		std::cout << "[LAYOUT]: no loaded sections\n";
+		return;
+	}
+
+	std::cout << "[LAYOUT]: " << sections.size() / blocks.size() << " sections, " << passes << " passes\n";
+	BenchmarkLayout<ArrayLayout::Linear>("linear", sections, passes);
+	BenchmarkLayout<ArrayLayout::Morton>("morton", sections, passes);
+	BenchmarkLayout<ArrayLayout::Brick>("brick ", sections, passes);
 }
 
 glm::vec2 World::World2ChunkCoords(const glm::vec3& coords) const
 {
-	return glm::vec2(static_cast<int>(coords.x / ChunkSize), static_cast<int>(coords.z / ChunkSize));
+	return glm::vec2(std::floor(coords.x / ChunkSize), std::floor(coords.z / ChunkSize));
+}
+
+std::pair<int, int> World::GetChunkKey(const glm::ivec3& position) const
+{
+	const int size = static_cast<int>(ChunkSize);
+	const int x = position.x >= 0 ? position.x / size : (position.x - size + 1) / size;
+	const int z = position.z >= 0 ? position.z / size : (position.z - size + 1) / size;
+	return { x, z };
+}
+
+Chunk* World::FindChunk(const std::pair<int, int>& key) const
+{
+	return Chunks.Get(key);
+}
+
+void World::RequestMesh(const std::pair<int, int>& key)
+{
+	ChunkSlot* const slot = Chunks.Find(key);
+	if (slot && slot->chunk && !slot->MeshRequested)
+	{
+		slot->MeshRequested = true;
+		ChunksToMesh.emplace_back(key);
+	}
+}
+
+void World::RequestEditMesh(const std::pair<int, int>& key)
+{
+	ChunkSlot* const slot = Chunks.Find(key);
+	if (slot && slot->chunk && !slot->Edited)
+	{
+		slot->Edited = true;
+		ChunksEdited.emplace_back(key);
+	}
 }
 
-void World::LoadChunks(const glm::vec2& playerChunkPos)
+bool World::ApplyEdit(const BlockEdit& edit)
 {
-	for (int x = -RenderDistance; x < RenderDistance; ++x) {
-		for (int z = -RenderDistance; z < RenderDistance; ++z) {
-			std::pair<int, int> chunkKey = { playerChunkPos.x + x, playerChunkPos.y + z };
+	const std::pair<int, int> key = GetChunkKey(edit.position);
+	Chunk* const chunk = Chunks.Get(key);
+	if (!chunk)
+	{
+		return true;
+	}
+
+	if (chunk->MeshQueued || chunk->LightQueued || chunk->IsPinned())
+	{
+		return false;
+	}
+	if (chunk->IsCompressed())
+	{
+		chunk->Decompress();
+	}
 
-			if (Chunks.find(chunkKey) == Chunks.end() &&
-				ChunksWaiting.find(chunkKey) == ChunksWaiting.end()) {
+	const int size = static_cast<int>(ChunkSize);
+	const unsigned x = static_cast<unsigned>(edit.position.x - key.first * size);
+	const unsigned y = static_cast<unsigned>(edit.position.y);
+	const unsigned z = static_cast<unsigned>(edit.position.z - key.second * size);
+	if (chunk->GetBlock(x, y, z) == edit.type)
+	{
+		return true;
+	}
 
-				float distance = glm::length(glm::vec2(x, z));
-				ChunksToGenerate.push({ chunkKey, distance });
-				ChunksWaiting.insert(chunkKey);
+	chunk->SetBlock(x, y, z, edit.type);
+	RequestEditMesh(key);
+	Chunks.At(key).LightEdits.emplace_back(x, y, z);
+	RequestLight(key);
+
+	// Blocks on the chunk border share a face with the neighbour chunk. Corner shading looks one
+	// block up and down, so on a section border the neighbour's next section changes too.
+	const unsigned index = y / ChunkSection::Size;
+	const unsigned localY = y % ChunkSection::Size;
+	auto markNeighbour = [this, &key, index, localY](const Side& side) {
+		const std::pair<int, int> neighbourKey = GetNeighbourKey(key, side);
+		if (Chunk* const neighbour = Chunks.Get(neighbourKey))
+		{
+			neighbour->MarkSectionDirty(index);
+			if (localY == 0 && index > 0)
+			{
+				neighbour->MarkSectionDirty(index - 1);
 			}
+			if (localY == ChunkSection::Size - 1 && index + 1 < Chunk::SectionCount)
+			{
+				neighbour->MarkSectionDirty(index + 1);
+			}
+			RequestEditMesh(neighbourKey);
 		}
+	};
+	if (x == 0)
+	{
+		markNeighbour(Side::LEFT);
+	}
+	if (x == ChunkSize - 1)
+	{
+		markNeighbour(Side::RIGHT);
+	}
+	if (z == 0)
+	{
+		markNeighbour(Side::BACK);
+	}
+	if (z == ChunkSize - 1)
+	{
+		markNeighbour(Side::FRONT);
+	}
+	return true;
+}
+
+void World::ProcessEdits()
+{
+	PendingEdits.erase(
+		std::remove_if(PendingEdits.begin(), PendingEdits.end(),
+			[this](const BlockEdit& edit) {
+				return ApplyEdit(edit);
+			}),
+		PendingEdits.end());
+
+	ProcessLightRequests();
+	LaunchEditMeshes();
+}
+
+void World::LaunchEditMeshes()
+{
+	ChunksEdited.erase(
+		std::remove_if(ChunksEdited.begin(), ChunksEdited.end(),
+			[this](const std::pair<int, int>& key) {
+				if (!UpdateChunkMesh(key, LastPlayerChunkPos, true))
+				{
+					return false;
+				}
+				if (ChunkSlot* const slot = Chunks.Find(key))
+				{
+					slot->Edited = false;
+				}
+				return true;
+			}),
+		ChunksEdited.end());
+}
+
+void World::FinishEdits()
+{
+	// Light is never waited on, edits whose light is done get their meshes launched here.
+	bool relit = false;
+	while (Chunk* const chunk = ChunksRelit.tryPop())
+	{
+		FinishLightTask(chunk, true);
+		relit = true;
+	}
+	if (relit)
+	{
+		LaunchEditMeshes();
+	}
+
+	// Remeshing the few sections an edit touches takes well under a frame, waiting here lets it show this frame.
+	const auto deadline = std::chrono::steady_clock::now() + MaxEditWait;
+	for (std::future<void>& future : EditFutures)
+	{
+		future.wait_until(deadline);
+	}
+	while (Chunk* const chunk = ChunksLinked.tryPop())
+	{
+		FinishLightTask(chunk, false);
 	}
 
+	while (Chunk* const chunk = ChunksRemeshed.tryPop())
+	{
+		chunk->GenerateOpenGLData();
+		chunk->MeshQueued = false;
+		RequestMesh(chunk->getKey());
+	}
+
+	EditFutures.erase(
+		std::remove_if(EditFutures.begin(), EditFutures.end(),
+			[](const std::future<void>& f) {
+				return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+			}),
+		EditFutures.end());
+}
+
+float World::GetViewDistance() const
+{
+	return GetDrawDistance() * ChunkSize;
+}
+
+bool World::IsInRenderRange(const std::pair<int, int>& key, const glm::vec2& playerChunkPos) const
+{
+	const float distance = GetDrawDistance();
+	const float x = key.first - playerChunkPos.x;
+	const float z = key.second - playerChunkPos.y;
+	return x * x + z * z < distance * distance;
+}
+
+LoadRegion World::GetLoadRegion(const glm::vec2& playerChunkPos, const glm::vec3& playerVelocity) const
+{
+	// Whole chunks of look-ahead so the region only changes on chunk steps.
+	const float maxLookAhead = GetDrawDistance() * 0.5f;
+	glm::vec2 lookAhead = glm::vec2(playerVelocity.x, playerVelocity.z) * (LookAheadTime / ChunkSize);
+	if (glm::length(lookAhead) > maxLookAhead)
+	{
+		lookAhead = glm::normalize(lookAhead) * maxLookAhead;
+	}
+	lookAhead = glm::round(lookAhead);
+
+	// Centred halfway to the look-ahead point and grown by the same amount, so the circle
+	// still covers the draw distance behind the player and reaches lookAhead further in front.
+	const float offset = glm::length(lookAhead) * 0.5f;
+	return { playerChunkPos + lookAhead * 0.5f, GetDrawDistance() + offset };
+}
+
+unsigned World::GetLod(const std::pair<int, int>& key, const glm::vec2& playerChunkPos) const
+{
+	const float distance = glm::max(glm::abs(key.first - playerChunkPos.x), glm::abs(key.second - playerChunkPos.y));
+
+	unsigned lod = 0;
+	float ring = RenderDistance;
+	while (lod + 1 < LodCount && distance >= ring)
+	{
+		ring *= 2.0f;
+		++lod;
+	}
+	return lod;
+}
+
+float World::GetDrawDistance() const
+{
+	return RenderDistance * static_cast<float>(1u << (LodCount - 1));
+}
+
+std::pair<int, int> World::GetNeighbourKey(const std::pair<int, int>& key, const Side& side)
+{
+	switch (side)
+	{
+	case Side::FRONT:
+		return { key.first, key.second + 1 };
+	case Side::BACK:
+		return { key.first, key.second - 1 };
+	case Side::LEFT:
+		return { key.first - 1, key.second };
+	case Side::RIGHT:
+		return { key.first + 1, key.second };
+	default:
+		return key;
+	}
+}
+
+void World::LoadChunks(const LoadRegion& region, const glm::vec2& playerChunkPos)
+{
+	// Only the part of each row that was not covered by the previous region is new,
+	// everything already inside it is loaded, waiting or blocked.
+	const int first = static_cast<int>(std::ceil(region.centre.y - region.radius));
+	const int last = static_cast<int>(std::floor(region.centre.y + region.radius));
+	for (int z = first; z <= last; ++z) {
+		const std::pair<int, int> row = region.GetRow(z);
+		const std::pair<int, int> loadedRow = LoadedRegion.GetRow(z);
+		for (int x = row.first; x <= row.second; ++x) {
+			if (x >= loadedRow.first && x <= loadedRow.second) {
+				x = loadedRow.second;
+				continue;
+			}
+
+			const std::pair<int, int> chunkKey = { x, z };
+			if (!LoadChunk(chunkKey, playerChunkPos)) {
+				BlockedLoads.emplace_back(chunkKey);
+			}
+		}
+	}
+	LoadedRegion = region;
+
 	ProcessChunkQueue();
 }
 
-void World::UnloadDistantChunks(const glm::vec2& playerChunkPos)
+bool World::LoadChunk(const std::pair<int, int>& key, const glm::vec2& playerChunkPos)
 {
-	auto it = Chunks.begin();
-	while (it != Chunks.end())
+	ChunkSlot& slot = Chunks.At(key);
+	if (slot.IsFree())
+	{
+		float distance = glm::length(glm::vec2(key.first - playerChunkPos.x, key.second - playerChunkPos.y));
+		ChunksToGenerate.push({ key, distance });
+		slot = ChunkSlot{ key };
+		slot.Waiting = true;
+		return true;
+	}
+	if (slot.Key == key)
+	{
+		return true;
+	}
+
+	// The previous occupant may have been busy when the player left it behind, it is
+	// only swept again on the next chunk crossing. Out of range it gives way now.
+	if (glm::distance(playerChunkPos, { slot.Key.first, slot.Key.second }) > GetDrawDistance() * 2 && UnloadChunk(slot))
 	{
-		if (glm::distance(playerChunkPos, { it->first.first, it->first.second }) > RenderDistance * 2)
+		return LoadChunk(key, playerChunkPos);
+	}
+	return false;
+}
+
+bool World::UnloadChunk(ChunkSlot& slot)
+{
+	Chunk* const chunk = slot.chunk;
+	if (!chunk || chunk->MeshQueued || chunk->LightQueued || chunk->IsPinned())
+	{
+		// Still generating, or a worker is still reading it.
+		return false;
+	}
+
+	// Edits would be lost to the next generation, they go to disk first.
+	if (chunk->HasUnsavedEdits())
+	{
+		SaveChunk(slot.Key, chunk);
+	}
+	ChunkPool::ReleaseChunk(chunk);
+	slot = ChunkSlot{ slot.Key };
+	return true;
+}
+
+void World::RetryBlockedLoads(const glm::vec2& playerChunkPos)
+{
+	BlockedLoads.erase(
+		std::remove_if(BlockedLoads.begin(), BlockedLoads.end(),
+			[this, &playerChunkPos](const std::pair<int, int>& key) {
+				const std::pair<int, int> row = LoadedRegion.GetRow(key.second);
+				return key.first < row.first || key.first > row.second || LoadChunk(key, playerChunkPos);
+			}),
+		BlockedLoads.end());
+}
+
+std::string World::GetSavePath(const std::pair<int, int>& key) const
+{
+	return SaveDirectory + "/chunk." + std::to_string(key.first) + "." + std::to_string(key.second) + ".rle";
+}
+
+void World::SaveChunk(const std::pair<int, int>& key, Chunk* chunk) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(SaveDirectory, error);
+	if (!chunk->Save(GetSavePath(key)))
+	{
+		PrintError("Couldn't save an edited chunk, its edits are lost.");
+	}
+}
+
+void World::UpdateLoadedChunks(const glm::vec2& playerChunkPos)
+{
+	for (ChunkSlot& slot : Chunks.GetSlots())
+	{
+		Chunk* const chunk = slot.chunk;
+		if (!chunk || chunk->MeshQueued || chunk->LightQueued || chunk->IsPinned())
 		{
-			ChunksWaiting.erase(it->first);
-			delete it->second;
-			it = Chunks.erase(it);
+			// Empty, or a worker is still reading it.
+			continue;
+		}
+
+		if (glm::distance(playerChunkPos, { slot.Key.first, slot.Key.second }) > GetDrawDistance() * 2)
+		{
+			UnloadChunk(slot);
+		}
+		else if (!IsInRenderRange(slot.Key, playerChunkPos))
+		{
+			// Between the render radius and the unload radius chunks are kept cold, as RLE blocks only.
+			if (!chunk->IsCompressed())
+			{
+				chunk->Compress();
+			}
 		}
 		else
 		{
-			++it;
+			// Cold chunks, chunks that crossed a LOD ring and full detail chunks whose
+			// neighbours may have changed detail get remeshed.
+			const unsigned lod = GetLod(slot.Key, playerChunkPos);
+			if (chunk->IsCompressed() || !chunk->HasMesh() || chunk->GetLod() != lod || lod == 0)
+			{
+				RequestMesh(slot.Key);
+			}
+		}
+	}
+}
+
+void World::ProcessMeshRequests()
+{
+	ChunksToMesh.erase(
+		std::remove_if(ChunksToMesh.begin(), ChunksToMesh.end(),
+			[this](const std::pair<int, int>& key) {
+				if (!UpdateChunkMesh(key, LastPlayerChunkPos))
+				{
+					return false;
+				}
+				if (ChunkSlot* const slot = Chunks.Find(key))
+				{
+					slot->MeshRequested = false;
+				}
+				return true;
+			}),
+		ChunksToMesh.end());
+}
+
+bool World::UpdateChunkMesh(const std::pair<int, int>& key, const glm::vec2& playerChunkPos, bool urgent)
+{
+	Chunk* const chunk = Chunks.Get(key);
+	if (!chunk || !IsInRenderRange(key, playerChunkPos))
+	{
+		return true;
+	}
+
+	// Requeued once the running task is uploaded, edits wait for it to keep their priority.
+	if (chunk->MeshQueued)
+	{
+		return !urgent;
+	}
+	// Meshes read the light, it has to be up to date first.
+	if (chunk->LightQueued || !Chunks.At(key).LightEdits.empty())
+	{
+		return false;
+	}
+
+	// Full detail chunks cull their border faces against full detail neighbours,
+	// so they wait until every neighbour inside the render range is generated.
+	const unsigned lod = GetLod(key, playerChunkPos);
+	std::array<Chunk*, 4> neighbours{};
+	unsigned mask = 0;
+	if (lod == 0)
+	{
+		for (int side = Side::FRONT; side <= Side::RIGHT; ++side)
+		{
+			const std::pair<int, int> neighbourKey = GetNeighbourKey(key, static_cast<Side>(side));
+			Chunk* const neighbour = Chunks.Get(neighbourKey);
+			if (!neighbour)
+			{
+				if (IsInRenderRange(neighbourKey, playerChunkPos))
+				{
+					return false;
+				}
+				continue;
+			}
+
+			if (GetLod(neighbourKey, playerChunkPos) == 0)
+			{
+				if (neighbour->LightQueued)
+				{
+					return false;
+				}
+				neighbours[side] = neighbour;
+				mask |= 1u << side;
+			}
+		}
+
+		if (chunk->GetLightStage() != LIGHT_LINKED)
+		{
+			RequestLight(key);
+			return false;
 		}
 	}
+
+	const bool layoutChanged = chunk->GetLod() != lod || chunk->GetNeighbourMask() != mask ||
+		(lod == 0 && chunk->HasBakedLight() == LightVolumes);
+	if (chunk->HasMesh() && !layoutChanged && !chunk->IsDirty())
+	{
+		return true;
+	}
+	if (urgent && CurrentEditTasksCount >= MaxEditTasks)
+	{
+		return false;
+	}
+
+	if (chunk->IsCompressed())
+	{
+		if (chunk->IsPinned())
+		{
+			return false;
+		}
+		chunk->Decompress();
+	}
+	if (layoutChanged)
+	{
+		chunk->MarkDirty();
+	}
+
+	for (Chunk* const neighbour : neighbours)
+	{
+		if (neighbour)
+		{
+			neighbour->Pin();
+		}
+	}
+	chunk->MeshQueued = true;
+
+	float distance = glm::length(glm::vec2(key.first - playerChunkPos.x, key.second - playerChunkPos.y));
+	if (urgent)
+	{
+		LaunchTask({ key, distance, chunk, lod, neighbours, true, !LightVolumes });
+	}
+	else
+	{
+		ChunksToGenerate.push({ key, distance, chunk, lod, neighbours, false, !LightVolumes });
+	}
+	return true;
 }
 
 void World::CleanupFinishedFutures()
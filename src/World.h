@@ -1,7 +1,8 @@
 #pragma once
 
 #include "Chunk.h"
-#include <unordered_map>
+#include "ChunkGrid.h"
+#include "OcclusionCuller.h"
 #include "glObjects/ShaderProgram.h"
 #include <functional>
 #include <utility>
@@ -45,20 +46,80 @@ private:
 	std::mutex Mutex;
 };
 
-struct PairHash
+struct BlockEdit
 {
-	template<class T1, class T2>
-	size_t operator()(const std::pair<T1, T2>& other) const
+	glm::ivec3 position;
+	CubeType type;
+};
+
+struct RaycastHit
+{
+	bool hit = false;
+	glm::ivec3 block{ 0 };
+	glm::ivec3 normal{ 0 }; // Zero when the ray starts inside a block.
+	Side face = Side::TOP;
+	float distance = 0.0f;
+	CubeType type = CubeType::EMPTY;
+};
+
+// Circle of chunk keys kept loaded.
+struct LoadRegion
+{
+	glm::vec2 centre{ 0.0f };
+	float radius = -1.0f; // Negative when nothing is loaded.
+
+	// Inclusive x range of the keys on row z, empty when first > second.
+	std::pair<int, int> GetRow(int z) const
 	{
-		auto hash1 = std::hash<T1>()(other.first);
-		auto hash2 = std::hash<T2>()(other.second);
-		return hash1 ^ (hash2 << 1);
+		const float dz = z - centre.y;
+		if (radius < 0.0f || glm::abs(dz) > radius)
+		{
+			return { 1, 0 };
+		}
+
+		const float halfWidth = std::sqrt(radius * radius - dz * dz);
+		return { static_cast<int>(std::ceil(centre.x - halfWidth)), static_cast<int>(std::floor(centre.x + halfWidth)) };
+	}
+
+	bool operator!=(const LoadRegion& other) const
+	{
+		return centre != other.centre || radius != other.radius;
 	}
 };
 
+// Step of the cave culling search, a section reached through a face.
+struct SectionVisit
+{
+	std::pair<int, int> key;
+	size_t slot = 0; // Chunks slot of key.
+	unsigned index = 0;
+	int from = -1; // Side the search came in through, -1 for the camera's section.
+	unsigned directions = 0; // Sides stepped through so far, the search never turns back.
+};
+
+// Chunk slot in the front to back draw order.
+struct DrawEntry
+{
+	float distance = 0.0f; // Squared, to the chunk's centre column.
+	size_t slot = 0;
+};
+
+// Counters of the last rendered frame.
+struct CullingStats
+{
+	unsigned drawn = 0; // Chunks with at least one section drawn.
+	unsigned occluded = 0; // Chunks with visible sections hidden behind occluders.
+	unsigned occluders = 0; // Quads rasterized into the depth pyramid.
+};
+
 struct ChunkTask {
 	std::pair<int, int> key;
 	float priority;
+	Chunk* chunk = nullptr; // Set when an already generated chunk only needs a new mesh.
+	unsigned lod = 0;
+	std::array<Chunk*, 4> neighbours{}; // Pinned until the mesh is built.
+	bool urgent = false; // Block edits, their own task limit and no upload budget.
+	bool bakeLight = true; // See Chunk::GenerateMesh.
 
 	bool operator<(const ChunkTask& other) const {
 		return priority > other.priority;
@@ -68,34 +129,133 @@ struct ChunkTask {
 class World
 {
 public:
-	World(unsigned chunkSize = 16u);
+	World();
 
-	void Update(const glm::vec3& playerPos);
+	void Update(const glm::vec3& playerPos, const glm::vec3& playerVelocity = glm::vec3(0.0f));
 	void Render(const ShaderProgram& shader, const Camera& camera, const glm::mat4& proj);
 	void Delete();
 
+	// Draw only the sections reachable from the camera's section through see-through blocks.
+	bool CaveCulling = true;
+	// Skip chunks hidden behind the solid terrain of the chunks around the camera.
+	bool OcclusionCulling = true;
+	int OccluderRadius = 4; // In chunks.
+	// Skip the face directions of a chunk that point away from the camera.
+	bool SideCulling = true;
+	// Full detail chunks read their light from a 3D texture, a light change then uploads the
+	// changed sections' light instead of remeshing them, and they aren't drawn until it exists.
+	// Off bakes the light into the meshes.
+	bool LightVolumes = true;
+	// Edited chunks are saved here as RLE blocks when unloaded and at exit, and loaded back
+	// instead of generated.
+	std::string SaveDirectory = "Saves";
+
+	const CullingStats& GetCullingStats() const;
+	void PrintCullingStats() const;
+
+	// Farthest rendered distance in blocks.
+	float GetViewDistance() const;
+
+	// World block coordinates, block (x, y, z) is centred on (x, y, z).
+	// Unloaded chunks read as EMPTY and ignore edits.
+	CubeType GetBlock(const glm::ivec3& position) const;
+	bool SetBlock(const glm::ivec3& position, CubeType type);
+
+	// Amanatides-Woo traversal, unloaded chunks are treated as air.
+	RaycastHit Raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance) const;
+	// Casts rayCount rays spread over a sphere around origin, returns rays per second.
+	double BenchmarkRaycast(const glm::vec3& origin, unsigned rayCount, float maxDistance) const;
+	// Remeshes every idle full detail chunk passes times, returns chunks meshed per second.
+	double BenchmarkMeshing(unsigned passes);
+	// Runs a face counting and a flood fill kernel over the loaded sections in every Array3D layout.
+	void BenchmarkLayouts(unsigned passes) const;
+
 private:
 	glm::vec2 World2ChunkCoords(const glm::vec3& coords) const;
+	bool IsInRenderRange(const std::pair<int, int>& key, const glm::vec2& playerChunkPos) const;
+	LoadRegion GetLoadRegion(const glm::vec2& playerChunkPos, const glm::vec3& playerVelocity) const;
+	unsigned GetLod(const std::pair<int, int>& key, const glm::vec2& playerChunkPos) const;
+	float GetDrawDistance() const;
+	static std::pair<int, int> GetNeighbourKey(const std::pair<int, int>& key, const Side& side);
 
-	void LoadChunks(const glm::vec2& playerChunkPos);
-	void UnloadDistantChunks(const glm::vec2& playerChunkPos);
+	void LoadChunks(const LoadRegion& region, const glm::vec2& playerChunkPos);
+	bool LoadChunk(const std::pair<int, int>& key, const glm::vec2& playerChunkPos);
+	void RetryBlockedLoads(const glm::vec2& playerChunkPos);
+	bool UnloadChunk(ChunkSlot& slot);
+	std::string GetSavePath(const std::pair<int, int>& key) const;
+	void SaveChunk(const std::pair<int, int>& key, Chunk* chunk) const;
+	void UpdateLoadedChunks(const glm::vec2& playerChunkPos);
 	void CleanupFinishedFutures();
 	void AddReadyChunks();
 	void ProcessChunkQueue();
+	void ProcessMeshRequests();
+	bool UpdateChunkMesh(const std::pair<int, int>& key, const glm::vec2& playerChunkPos, bool urgent = false);
+	void LaunchTask(const ChunkTask& task);
+
+	// Light tasks own the chunk and its existing neighbours, see LightEngine. Chunks are lit on
+	// their own when generated and linked to their neighbours before their first full detail mesh,
+	// edits relight only what they changed.
+	void RequestLight(const std::pair<int, int>& key);
+	void ProcessLightRequests();
+	bool LaunchLightTask(const std::pair<int, int>& key);
+	void FinishLightTask(Chunk* chunk, bool urgent);
+	// Brings a drawn chunk's light volume up to date, unless a light task owns part of its neighbourhood.
+	void UpdateLightVolume(const std::pair<int, int>& key, Chunk* chunk);
+
+	std::pair<int, int> GetChunkKey(const glm::ivec3& position) const;
+	Chunk* FindChunk(const std::pair<int, int>& key) const;
+	// Fills VisibleSections, false when the camera is outside the meshed world and everything is drawn.
+	bool FindVisibleSections(const Camera& camera);
+	void BuildOccluders(const Camera& camera, const glm::mat4& proj);
+	void SortDrawOrder(const glm::vec3& eye);
+	bool IsChunkOccluded(const std::pair<int, int>& key, unsigned sections) const;
+
+	void RequestMesh(const std::pair<int, int>& key);
+	void RequestEditMesh(const std::pair<int, int>& key);
+	bool ApplyEdit(const BlockEdit& edit);
+	void ProcessEdits();
+	void LaunchEditMeshes();
+	void FinishEdits();
 
 private:
-	std::unordered_map<std::pair<int, int>, Chunk*, PairHash> Chunks;
+	ChunkGrid Chunks;
 	std::priority_queue<ChunkTask> ChunksToGenerate;
-	std::unordered_set<std::pair<int, int>, PairHash> ChunksWaiting;
+	std::vector<std::pair<int, int>> ChunksToMesh; // Deduplicated by ChunkSlot::MeshRequested.
+	LoadRegion LoadedRegion;
+	std::vector<std::pair<int, int>> BlockedLoads; // Slot still held by a far chunk a worker is reading.
+
+	// Block edits.
+	std::vector<BlockEdit> PendingEdits;
+	std::vector<std::pair<int, int>> ChunksEdited; // Deduplicated by ChunkSlot::Edited.
+	std::vector<std::pair<int, int>> ChunksToLight; // Deduplicated by ChunkSlot::LightRequested.
+
+	// Cave culling, section masks indexed like the chunk slots.
+	std::vector<unsigned> VisibleSections;
+	std::vector<SectionVisit> SectionQueue;
+	OcclusionCuller Occlusion;
+	CullingStats Stats;
+	std::vector<DrawEntry> DrawOrder; // Every slot, nearest chunks first, empty slots last.
 
+	// Full detail radius in chunks, every further LOD ring doubles it.
 	float RenderDistance = 5.0f;
+	unsigned LodCount = 3;
+	// The load circle is pushed this many seconds of travel ahead, up to half the draw distance.
+	float LookAheadTime = 2.0f;
 	glm::vec2 LastPlayerChunkPos;
-	unsigned ChunkSize;
+	static constexpr unsigned ChunkSize = Chunk::SizeX;
 
 	// async stuff.
 	ChunkQueue ChunksGenerated;
+	ChunkQueue ChunksRemeshed;
+	ChunkQueue ChunksLinked;
+	ChunkQueue ChunksRelit; // Light tasks of edits.
 	std::vector<std::future<void>> Futures;
+	std::vector<std::future<void>> EditFutures;
+	const std::chrono::milliseconds MaxEditWait{ 4 };
 	std::mutex Mutex;
 	const int MaxTasks = 16;
 	std::atomic<int> CurrentTasksCount{ 0 };
+	// Edits have their own budget so they never wait behind streaming, overflow stays in ChunksEdited.
+	const int MaxEditTasks = 4;
+	std::atomic<int> CurrentEditTasksCount{ 0 };
 };
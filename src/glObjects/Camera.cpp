@@ -5,6 +5,7 @@ Camera::Camera()
 	worldUp = glm::vec3(0.0f);
 	pos = glm::vec3(0.0f);
 	front = glm::vec3(0.0f);
+	velocity = glm::vec3(0.0f);
 	view = glm::mat4(1.0f);
 }
 
@@ -17,6 +18,8 @@ void Camera::Init(glm::vec3& up)
 
 void Camera::processInput(GLFWwindow* window, float dt)
 {
+	const glm::vec3 lastPos = pos;
+
 	if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
 	{
 		pos += front * speed * dt;
@@ -41,6 +44,8 @@ void Camera::processInput(GLFWwindow* window, float dt)
 	{
 		pos -= worldUp * speed * dt;
 	}
+
+	velocity = dt > 0.0f ? (pos - lastPos) / dt : glm::vec3(0.0f);
 }
 
 void Camera::calculateMatrix()
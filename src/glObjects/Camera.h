@@ -39,4 +39,5 @@ public:
 	float fov = 45.0f;
 	glm::vec3 pos;
 	glm::vec3 front;
+	glm::vec3 velocity; // Units per second over the last processInput.
 };
@@ -1,4 +1,5 @@
 #include "EBO.h"
+#include "../GPUResourceManager.h"
 
 EBO::EBO() : ID(0)
 {
@@ -6,9 +7,10 @@ EBO::EBO() : ID(0)
 
 EBO::EBO(const void* data, GLsizeiptr size, GLenum usage)
 {
-	glGenBuffers(1, &ID);
+	ID = GPUResourceManager::Create(GPUResourceType::ELEMENT_BUFFER);
 	Bind();
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, usage);
+	GPUResourceManager::SetSize(GPUResourceType::ELEMENT_BUFFER, ID, static_cast<size_t>(size));
 }
 
 void EBO::Bind() const
@@ -21,7 +23,22 @@ void EBO::Unbind() const
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
 
+void EBO::Update(const void* data, GLsizeiptr size, GLintptr offset) const
+{
+	Bind();
+	glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, size, data);
+}
+
+void EBO::CopyFrom(const EBO& source, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) const
+{
+	glBindBuffer(GL_COPY_READ_BUFFER, source.ID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, readOffset, writeOffset, size);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
 void EBO::Delete() const
 {
-	glDeleteBuffers(1, &ID);
+	GPUResourceManager::Release(GPUResourceType::ELEMENT_BUFFER, ID);
 }
@@ -11,6 +11,10 @@ public:
 	void Bind() const;
 	void Unbind() const;
 	void Delete() const;
+	// Overwrites part of the existing storage.
+	void Update(const void* data, GLsizeiptr size, GLintptr offset = 0) const;
+	// GPU side copy out of another buffer, nothing goes through the CPU.
+	void CopyFrom(const EBO& source, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) const;
 
 public:
 	GLuint ID;
@@ -0,0 +1,61 @@
+#include "SamplesQuery.h"
+
+SamplesQuery::SamplesQuery()
+{
+}
+
+void SamplesQuery::Init()
+{
+	glGenQueries(QueryCount, IDs.data());
+}
+
+void SamplesQuery::Begin(GLuint pixels)
+{
+	Poll();
+	// Still in flight after QueryCount frames, the query is reused and its count never read.
+	Pending[Current] = false;
+	Pixels[Current] = pixels;
+	glBeginQuery(GL_SAMPLES_PASSED, IDs[Current]);
+}
+
+void SamplesQuery::End()
+{
+	glEndQuery(GL_SAMPLES_PASSED);
+	Pending[Current] = true;
+	Current = (Current + 1) % QueryCount;
+}
+
+void SamplesQuery::Delete()
+{
+	glDeleteQueries(QueryCount, IDs.data());
+	IDs.fill(0);
+	Pending.fill(false);
+}
+
+SamplesQuery::Count SamplesQuery::GetResult() const
+{
+	return Result;
+}
+
+void SamplesQuery::Poll()
+{
+	// Oldest first, so Result always moves forward.
+	for (unsigned offset{}; offset < QueryCount; ++offset)
+	{
+		const unsigned index = (Current + offset) % QueryCount;
+		if (!Pending[index])
+		{
+			continue;
+		}
+
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(IDs[index], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+		{
+			break;
+		}
+		glGetQueryObjectuiv(IDs[index], GL_QUERY_RESULT, &Result.Samples);
+		Result.Pixels = Pixels[index];
+		Pending[index] = false;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "GLAD/glad.h"
+#include <array>
+
+// Counts the samples that pass the depth test between Begin and End. Results are read a few
+// frames late, whenever the driver has them, so the CPU never waits on the GPU.
+class SamplesQuery
+{
+public:
+	struct Count
+	{
+		GLuint Samples = 0;
+		// Framebuffer size when the samples were counted.
+		GLuint Pixels = 0;
+	};
+
+	SamplesQuery();
+
+	void Init();
+	void Begin(GLuint pixels);
+	void End();
+	void Delete();
+
+	// Latest finished count, 0 until the first one is in.
+	Count GetResult() const;
+
+private:
+	void Poll();
+
+private:
+	static constexpr unsigned QueryCount = 3u;
+	std::array<GLuint, QueryCount> IDs{};
+	std::array<bool, QueryCount> Pending{};
+	std::array<GLuint, QueryCount> Pixels{};
+	unsigned Current = 0;
+	Count Result;
+};
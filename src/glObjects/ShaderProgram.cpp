@@ -1,12 +1,12 @@
 #include "ShaderProgram.h"
 
-ShaderProgram::ShaderProgram() : ID(0)
+ShaderProgram::ShaderProgram() : ID(0), variant(SHADER_FULL)
 {
 }
 
-ShaderProgram::ShaderProgram(const char* vertexSourcePath, const char* fragmentSourcePath) : ID(0)
+ShaderProgram::ShaderProgram(const char* vertexSourcePath, const char* fragmentSourcePath, ShaderVariant variant) : ID(0), variant(variant)
 {
-	Init(vertexSourcePath, fragmentSourcePath);
+	Init(vertexSourcePath, fragmentSourcePath, variant);
 }
 
 ShaderProgram ShaderProgram::Bind() const
@@ -25,13 +25,25 @@ void ShaderProgram::Delete() const
 	glDeleteProgram(ID);
 }
 
-void ShaderProgram::Init(const char* vertexSourcePath, const char* fragmentSourcePath)
+void ShaderProgram::Init(const char* vertexSourcePath, const char* fragmentSourcePath, ShaderVariant variant)
 {
+	this->variant = variant;
+	const std::string defines = GetVariantDefines(variant);
+	std::string vertexSourceString = InsertDefines(GetFileContent(vertexSourcePath), defines);
+	std::string fragmentSourceString = InsertDefines(GetFileContent(fragmentSourcePath), defines);
+
+	// Linking is skipped when the driver still has a binary of these exact sources.
+	const uint64_t sourceHash = HashBytes(fragmentSourceString.data(), fragmentSourceString.size(),
+		HashBytes(vertexSourceString.data(), vertexSourceString.size()));
+	const std::string cachePath = GetCachePath(vertexSourcePath, variant);
+	if (ID = ProgramCache::Load(cachePath, sourceHash); ID != 0)
+	{
+		return;
+	}
+
 	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 
-	std::string vertexSourceString = GetFileContent(vertexSourcePath);
-	std::string fragmentSourceString = GetFileContent(fragmentSourcePath);
 	const char* vertexSource = vertexSourceString.c_str();
 	const char* fragmentSource = fragmentSourceString.c_str();
 
@@ -47,29 +59,63 @@ void ShaderProgram::Init(const char* vertexSourcePath, const char* fragmentSourc
 	ID = glCreateProgram();
 	glAttachShader(ID, vertexShader);
 	glAttachShader(ID, fragmentShader);
+	ProgramCache::PrepareLink(ID);
 	glLinkProgram(ID);
 
-	CheckProgramStates(ID);
+	if (CheckProgramStates(ID))
+	{
+		ProgramCache::Store(cachePath, sourceHash, ID);
+	}
 
 	glDeleteShader(vertexShader);
 	glDeleteShader(fragmentShader);
 }
 
+bool ShaderProgram::IsLit() const
+{
+	return variant != SHADER_NO_LIGHT;
+}
+
+bool ShaderProgram::HasPointLights() const
+{
+	return variant == SHADER_FULL;
+}
+
+GLint ShaderProgram::GetUniformLocation(const char* name) const
+{
+	return glGetUniformLocation(ID, name);
+}
+
 void ShaderProgram::BindUniform1i(const char* name, GLint value) const
 {
 	glUniform1i(glGetUniformLocation(ID, name), value);
 }
 
+void ShaderProgram::BindUniform1i(GLint location, GLint value) const
+{
+	glUniform1i(location, value);
+}
+
 void ShaderProgram::BindUniform1f(const char* name, GLfloat value) const
 {
 	glUniform1f(glGetUniformLocation(ID, name), value);
 }
 
+void ShaderProgram::BindUniformMat3(const char* name, const GLfloat* value) const
+{
+	glUniformMatrix3fv(glGetUniformLocation(ID, name), 1, GL_FALSE, value);
+}
+
 void ShaderProgram::BindUniformMat4(const char* name, const GLfloat* value) const
 {
 	glUniformMatrix4fv(glGetUniformLocation(ID, name), 1, GL_FALSE, value);
 }
 
+void ShaderProgram::BindUniformVec2(const char* name, float x, float y) const
+{
+	glUniform2f(glGetUniformLocation(ID, name), x, y);
+}
+
 void ShaderProgram::BindUniformVec3(const char* name, float x, float y, float z) const
 {
 	glUniform3f(glGetUniformLocation(ID, name), x, y, z);
@@ -88,17 +134,6 @@ void ShaderProgram::BindDirectLight(const DirectLight& light) const
 	BindUniformVec3("dLight.specular", light.specular);
 }
 
-void ShaderProgram::BindPointLight(const PointLight& light, int index) const
-{
-	BindUniformVec3(std::format("pLight[{}].position", index).c_str(), light.position);
-	BindUniformVec3(std::format("pLight[{}].ambient", index).c_str(), light.ambient);
-	BindUniformVec3(std::format("pLight[{}].diffuse", index).c_str(), light.diffuse);
-	BindUniformVec3(std::format("pLight[{}].specular", index).c_str(), light.specular);
-	BindUniform1f(std::format("pLight[{}].attenConstant", index).c_str(), light.attenConstant);
-	BindUniform1f(std::format("pLight[{}].attenLinear", index).c_str(), light.attenLinear);
-	BindUniform1f(std::format("pLight[{}].attenQuadratic", index).c_str(), light.attenQuadratic);
-}
-
 void ShaderProgram::BindSpotLight(const SpotLight& light) const
 {
 	BindUniformVec3("sLight.position", light.position);
@@ -119,12 +154,32 @@ void ShaderProgram::BindMaterial(const Material& material) const
 	BindUniform1i("material.specular", material.specular);
 	BindUniform1i("material.emissive", material.emissive);
 	BindUniform1f("material.shininess", material.shininess);
-	BindUniformVec3("material.tintTop", material.tintTop);
 }
 
-void ShaderProgram::SetLights(int value) const
+std::string ShaderProgram::GetVariantDefines(ShaderVariant variant)
 {
-	BindUniform1i("lightBits", value);
+	switch (variant)
+	{
+	case SHADER_NO_LIGHT:
+		return "";
+	case SHADER_DIRECTIONAL:
+		return "#define DIRECTIONAL_LIGHTING\n";
+	default:
+		return "#define DIRECTIONAL_LIGHTING\n#define POINT_LIGHTING\n#define SPOT_LIGHTING\n";
+	}
+}
+
+const char* ShaderProgram::GetVariantName(ShaderVariant variant)
+{
+	switch (variant)
+	{
+	case SHADER_NO_LIGHT:
+		return "nolight";
+	case SHADER_DIRECTIONAL:
+		return "directional";
+	default:
+		return "full";
+	}
 }
 
 void ShaderProgram::CheckShaderStates(GLuint shader, const char* shaderName)
@@ -139,7 +194,32 @@ void ShaderProgram::CheckShaderStates(GLuint shader, const char* shaderName)
 	}
 }
 
-void ShaderProgram::CheckProgramStates(GLuint program)
+std::string ShaderProgram::GetCachePath(const char* vertexSourcePath, ShaderVariant variant)
+{
+	// "Shaders/default.vertex" is cached as "Shaders/default.<variant>.program".
+	std::string path = vertexSourcePath;
+	const size_t dot = path.find_last_of('.');
+	const size_t slash = path.find_last_of("/\\");
+	if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+	{
+		path.erase(dot);
+	}
+	return path + '.' + GetVariantName(variant) + ".program";
+}
+
+std::string ShaderProgram::InsertDefines(const std::string& source, const std::string& defines)
+{
+	// #version has to stay the first line of the shader.
+	const size_t version = source.find("#version");
+	const size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version);
+	if (lineEnd == std::string::npos)
+	{
+		return defines + source;
+	}
+	return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+}
+
+bool ShaderProgram::CheckProgramStates(GLuint program)
 {
 	int success;
 	char errorInfo[512];
@@ -149,4 +229,5 @@ void ShaderProgram::CheckProgramStates(GLuint program)
 		glGetProgramInfoLog(program, 512, 0, errorInfo);
 		std::cout << "ERROR::PROGRAM::LINK\n" << errorInfo;
 	}
+	return success;
 }
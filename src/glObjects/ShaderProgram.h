@@ -6,11 +6,19 @@
 #include "glm/gtc/matrix_transform.hpp"
 
 #include "../helpers.h"
+#include "../ProgramCache.h"
 
-#define DIRECTIONAL_LIGHT 0x00000001
-#define	POINT_LIGHT 0x00000002
-#define SPOT_LIGHT 0x00000004
-#define NO_LIGHT 0x00000008
+#include <array>
+
+// Compile-time specialisations of a shader, each one is its own program and the pass picks
+// the one it needs, so the shaders never branch on which lights are enabled.
+enum ShaderVariant
+{
+	SHADER_NO_LIGHT = 0,
+	SHADER_DIRECTIONAL,
+	SHADER_FULL,
+	SHADER_VARIANT_COUNT,
+};
 
 struct Material
 {
@@ -21,14 +29,11 @@ struct Material
 	GLuint specular;
 	GLuint emissive;
 	float shininess = 32.0f;
-	
-	glm::vec3 tintTop = glm::vec3(1.0f);
 
 	friend std::ostream& operator<<(std::ostream& stream, const Material& material)
 	{
 		stream << "diffuse: " << material.diffuse << ", specular: " << material.specular
-			<< ", emissive: " << material.emissive << ", shininess: " << material.shininess
-			<< ", tintTop: (" << material.tintTop.x << "; " << material.tintTop.y << "; " << material.tintTop.z << ')';
+			<< ", emissive: " << material.emissive << ", shininess: " << material.shininess;
 		return stream;
 	}
 };
@@ -95,32 +100,49 @@ class ShaderProgram
 {
 public:
 	ShaderProgram();
-	ShaderProgram(const char* vertexSourcePath, const char* fragmentSourcePath);
+	// Linked programs are kept in a binary cache next to the vertex source, see ProgramCache.
+	ShaderProgram(const char* vertexSourcePath, const char* fragmentSourcePath, ShaderVariant variant = SHADER_FULL);
 
 	ShaderProgram Bind() const;
 	void Unbind() const;
 	void Delete() const;
 
-	void Init(const char* vertexSourcePath, const char* fragmentSourcePath);
+	void Init(const char* vertexSourcePath, const char* fragmentSourcePath, ShaderVariant variant = SHADER_FULL);
+	// Unlit variants have no lighting inputs, their uniforms needn't be set at all.
+	bool IsLit() const;
+	// Point lit variants sample the light cluster buffers, see LightClusters::Bind.
+	bool HasPointLights() const;
 
+	// -1 when the program has no such active uniform.
+	GLint GetUniformLocation(const char* name) const;
 	void BindUniform1i(const char* name, GLint value) const;
+	void BindUniform1i(GLint location, GLint value) const;
 	void BindUniform1f(const char* name, GLfloat value) const;
+	void BindUniformMat3(const char* name, const GLfloat* value) const;
 	void BindUniformMat4(const char* name, const GLfloat* value) const;
+	void BindUniformVec2(const char* name, float x, float y) const;
 	void BindUniformVec3(const char* name, float x, float y, float z) const;
 	void BindUniformVec3(const char* name, const glm::vec3& vec) const;
 
 	void BindDirectLight(const DirectLight& light) const;
-	void BindPointLight(const PointLight& light, int index) const;
 	void BindSpotLight(const SpotLight& light) const;
 
 	void BindMaterial(const Material& material) const;
 
-	void SetLights(int value) const;
+	// Defines the variant adds right after the #version line.
+	static std::string GetVariantDefines(ShaderVariant variant);
+	static const char* GetVariantName(ShaderVariant variant);
 
 private:
 	void CheckShaderStates(GLuint shader, const char* shaderName);
-	void CheckProgramStates(GLuint program);
+	bool CheckProgramStates(GLuint program);
+
+	static std::string GetCachePath(const char* vertexSourcePath, ShaderVariant variant);
+	static std::string InsertDefines(const std::string& source, const std::string& defines);
 
 public:
 	GLuint ID;
+	ShaderVariant variant;
 };
+
+using ShaderVariants = std::array<ShaderProgram, SHADER_VARIANT_COUNT>;
@@ -1,4 +1,5 @@
 #include "Texture2D.h"
+#include "../GPUResourceManager.h"
 
 Texture2D::Texture2D() : ID(0), unit(0)
 {
@@ -14,7 +15,7 @@ Texture2D::Texture2D(const char* path, int unit, GLint format, GLint wraps, GLin
 		PrintError("Couldn't load the texture source.");
 	}
 
-	glGenTextures(1, &ID);
+	ID = GPUResourceManager::Create(GPUResourceType::TEXTURE);
 	Bind();
 
 	GLuint internalFormat = format;
@@ -47,6 +48,7 @@ Texture2D::Texture2D(const char* path, int unit, GLint format, GLint wraps, GLin
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+	GPUResourceManager::SetSize(GPUResourceType::TEXTURE, ID, static_cast<size_t>(width) * height * channels);
 	//glGenerateMipmap(GL_TEXTURE_2D);
 	Unbind();
 
@@ -66,5 +68,5 @@ void Texture2D::Unbind() const
 
 void Texture2D::Delete() const
 {
-	glDeleteTextures(1, &ID);
+	GPUResourceManager::Release(GPUResourceType::TEXTURE, ID);
 }
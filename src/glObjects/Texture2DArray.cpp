@@ -0,0 +1,62 @@
+#include "Texture2DArray.h"
+#include "../GPUResourceManager.h"
+
+Texture2DArray::Texture2DArray() : ID(0), unit(0), layers(0)
+{
+}
+
+Texture2DArray::Texture2DArray(const char* path, unsigned tilesPerRow, int unit) : ID(0), unit(unit), layers(0)
+{
+	CookedTexture texture;
+	if (TextureCache::Load(path, tilesPerRow, texture))
+	{
+		Upload(texture);
+	}
+}
+
+Texture2DArray::Texture2DArray(const CookedTexture& texture, int unit) : ID(0), unit(unit), layers(0)
+{
+	Upload(texture);
+}
+
+void Texture2DArray::Upload(const CookedTexture& texture)
+{
+	layers = texture.layers;
+	ID = GPUResourceManager::Create(GPUResourceType::TEXTURE);
+	Bind();
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.levels.size()) - 1);
+
+	// The mip chain is cooked along with the texture, nothing is generated on the driver side.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (size_t level{}; level < texture.levels.size(); ++level)
+	{
+		const CookedLevel& cooked = texture.levels[level];
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), GL_RGBA8, cooked.width, cooked.height, layers, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, &texture.pixels[cooked.offset]);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	GPUResourceManager::SetSize(GPUResourceType::TEXTURE, ID, texture.pixels.size());
+	Unbind();
+}
+
+void Texture2DArray::Bind() const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, ID);
+}
+
+void Texture2DArray::Unbind() const
+{
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void Texture2DArray::Delete() const
+{
+	GPUResourceManager::Release(GPUResourceType::TEXTURE, ID);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "GLAD/glad.h"
+#include "../TextureCache.h"
+
+// Tile atlas split into one layer per tile, so every tile gets its own full mip chain
+// and neither mipmapping nor filtering can bleed into the neighbouring tiles.
+class Texture2DArray
+{
+public:
+	Texture2DArray();
+	// Layer (y * tilesPerRow + x) is the tile in column x, row y counted from the bottom of the image.
+	// Goes through the texture cache, the source is only decoded when the cache is stale.
+	Texture2DArray(const char* path, unsigned tilesPerRow, int unit);
+	Texture2DArray(const CookedTexture& texture, int unit);
+
+	void Bind() const;
+	void Unbind() const;
+	void Delete() const;
+
+	bool operator==(const Texture2DArray& other) const
+	{
+		return ID == other.ID;
+	}
+
+	struct Hash
+	{
+		size_t operator()(const Texture2DArray& texture) const
+		{
+			return std::hash<GLuint>()(texture.ID);
+		}
+	};
+
+private:
+	void Upload(const CookedTexture& texture);
+
+public:
+	GLuint ID;
+	int unit;
+	unsigned layers;
+};
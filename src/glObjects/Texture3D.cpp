@@ -0,0 +1,49 @@
+#include "Texture3D.h"
+#include "../GPUResourceManager.h"
+
+Texture3D::Texture3D() : ID(0), unit(0)
+{
+}
+
+Texture3D::Texture3D(GLsizei width, GLsizei height, GLsizei depth, int unit) : ID(0), unit(unit)
+{
+	ID = GPUResourceManager::Create(GPUResourceType::TEXTURE);
+	Bind();
+
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAX_LEVEL, 0);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RG8, width, height, depth, 0, GL_RG, GL_UNSIGNED_BYTE, nullptr);
+
+	GPUResourceManager::SetSize(GPUResourceType::TEXTURE, ID, static_cast<size_t>(width) * height * depth * 2);
+	Unbind();
+}
+
+void Texture3D::Update(GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, const GLubyte* texels) const
+{
+	Bind();
+	// Rows of two byte texels aren't 4 byte aligned when the width is odd.
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexSubImage3D(GL_TEXTURE_3D, 0, x, y, z, width, height, depth, GL_RG, GL_UNSIGNED_BYTE, texels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	Unbind();
+}
+
+void Texture3D::Bind() const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_3D, ID);
+}
+
+void Texture3D::Unbind() const
+{
+	glBindTexture(GL_TEXTURE_3D, 0);
+}
+
+void Texture3D::Delete() const
+{
+	GPUResourceManager::Release(GPUResourceType::TEXTURE, ID);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "GLAD/glad.h"
+
+// Single level RG8 volume with linear filtering, two bytes per texel.
+// Filled and refreshed one box at a time, nothing is kept on the CPU side.
+class Texture3D
+{
+public:
+	Texture3D();
+	Texture3D(GLsizei width, GLsizei height, GLsizei depth, int unit);
+
+	// Texels run x fastest, then y, then z.
+	void Update(GLint x, GLint y, GLint z, GLsizei width, GLsizei height, GLsizei depth, const GLubyte* texels) const;
+
+	void Bind() const;
+	void Unbind() const;
+	void Delete() const;
+
+public:
+	GLuint ID;
+	int unit;
+};
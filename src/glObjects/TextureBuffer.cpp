@@ -0,0 +1,58 @@
+#include "TextureBuffer.h"
+#include "../GPUResourceManager.h"
+#include <algorithm>
+#include <bit>
+
+// Empty buffers still get storage, a buffer texture without any is incomplete.
+static constexpr GLsizeiptr MinCapacity = 256;
+
+TextureBuffer::TextureBuffer() : ID(0), bufferID(0), unit(0), capacity(0)
+{
+}
+
+TextureBuffer::TextureBuffer(GLenum format, int unit) : ID(0), bufferID(0), unit(unit), capacity(MinCapacity)
+{
+	bufferID = GPUResourceManager::Create(GPUResourceType::TEXTURE_BUFFER);
+	glBindBuffer(GL_TEXTURE_BUFFER, bufferID);
+	glBufferData(GL_TEXTURE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	GPUResourceManager::SetSize(GPUResourceType::TEXTURE_BUFFER, bufferID, static_cast<size_t>(capacity));
+
+	ID = GPUResourceManager::Create(GPUResourceType::TEXTURE);
+	Bind();
+	glTexBuffer(GL_TEXTURE_BUFFER, format, bufferID);
+	Unbind();
+}
+
+void TextureBuffer::Upload(const void* data, GLsizeiptr size)
+{
+	glBindBuffer(GL_TEXTURE_BUFFER, bufferID);
+	if (size > capacity)
+	{
+		capacity = static_cast<GLsizeiptr>(std::bit_ceil(static_cast<size_t>(size)));
+		GPUResourceManager::SetSize(GPUResourceType::TEXTURE_BUFFER, bufferID, static_cast<size_t>(capacity));
+	}
+	glBufferData(GL_TEXTURE_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+	if (size > 0)
+	{
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, size, data);
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void TextureBuffer::Bind() const
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, ID);
+}
+
+void TextureBuffer::Unbind() const
+{
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void TextureBuffer::Delete() const
+{
+	GPUResourceManager::Release(GPUResourceType::TEXTURE, ID);
+	GPUResourceManager::Release(GPUResourceType::TEXTURE_BUFFER, bufferID);
+}
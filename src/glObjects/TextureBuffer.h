@@ -0,0 +1,26 @@
+#pragma once
+
+#include "GLAD/glad.h"
+
+// Buffer texture, shaders read it with texelFetch through a samplerBuffer. The whole content is
+// replaced on every upload, the storage is orphaned first so the draws still reading the old
+// content don't stall the upload. It only grows, to the next power of two that fits.
+class TextureBuffer
+{
+public:
+	TextureBuffer();
+	// Format is a sized texel format, GL_RGBA32F, GL_R32UI and so on.
+	TextureBuffer(GLenum format, int unit);
+
+	void Upload(const void* data, GLsizeiptr size);
+
+	void Bind() const;
+	void Unbind() const;
+	void Delete() const;
+
+public:
+	GLuint ID;
+	GLuint bufferID;
+	int unit;
+	GLsizeiptr capacity;
+};
@@ -1,8 +1,13 @@
 #include "VAO.h"
+#include "../GPUResourceManager.h"
 
-VAO::VAO()
+VAO::VAO() : ID(0)
 {
-	glGenVertexArrays(1, &ID);
+}
+
+void VAO::Init()
+{
+	ID = GPUResourceManager::Create(GPUResourceType::VERTEX_ARRAY);
 }
 
 void VAO::Bind() const
@@ -17,11 +22,11 @@ void VAO::Unbind() const
 
 void VAO::Delete() const
 {
-	glDeleteVertexArrays(1, &ID);
+	GPUResourceManager::Release(GPUResourceType::VERTEX_ARRAY, ID);
 }
 
-void VAO::LinkAttrib(GLuint index, GLint elements, GLenum type, GLsizei stride, const void* offset)
+void VAO::LinkAttrib(GLuint index, GLint elements, GLenum type, GLsizei stride, const void* offset, GLboolean normalized)
 {
-	glVertexAttribPointer(index, elements, type, GL_FALSE, stride, offset);
+	glVertexAttribPointer(index, elements, type, normalized, stride, offset);
 	glEnableVertexAttribArray(index);
 }
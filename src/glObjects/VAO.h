@@ -7,11 +7,12 @@ class VAO
 public:
 	VAO();
 
+	void Init();
 	void Bind() const;
 	void Unbind() const;
 	void Delete() const;
 
-	void LinkAttrib(GLuint index, GLint elements, GLenum type, GLsizei stride, const void* offset);
+	void LinkAttrib(GLuint index, GLint elements, GLenum type, GLsizei stride, const void* offset, GLboolean normalized = GL_FALSE);
 
 public:
 	GLuint ID;
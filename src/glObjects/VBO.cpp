@@ -1,4 +1,5 @@
 #include "VBO.h"
+#include "../GPUResourceManager.h"
 
 VBO::VBO() : ID(0)
 {
@@ -6,9 +7,10 @@ VBO::VBO() : ID(0)
 
 VBO::VBO(const void* data, GLsizeiptr size, GLenum usage)
 {
-	glGenBuffers(1, &ID);
+	ID = GPUResourceManager::Create(GPUResourceType::VERTEX_BUFFER);
 	Bind();
 	glBufferData(GL_ARRAY_BUFFER, size, data, usage);
+	GPUResourceManager::SetSize(GPUResourceType::VERTEX_BUFFER, ID, static_cast<size_t>(size));
 }
 
 void VBO::Bind() const
@@ -21,7 +23,22 @@ void VBO::Unbind() const
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void VBO::Update(const void* data, GLsizeiptr size, GLintptr offset) const
+{
+	Bind();
+	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+}
+
+void VBO::CopyFrom(const VBO& source, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size) const
+{
+	glBindBuffer(GL_COPY_READ_BUFFER, source.ID);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, ID);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, readOffset, writeOffset, size);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
 void VBO::Delete() const
 {
-	glDeleteBuffers(1, &ID);
+	GPUResourceManager::Release(GPUResourceType::VERTEX_BUFFER, ID);
 }
@@ -18,4 +18,17 @@ std::string GetFileContent(const char* path)
 		file.close();
 		return content;
 	}
+	return std::string();
+}
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t hash = seed;
+	for (size_t i{}; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
 }
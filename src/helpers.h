@@ -3,6 +3,9 @@
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <cstdint>
 
 void PrintError(const char* msg);
 std::string GetFileContent(const char* path);
+// FNV-1a, used to key the on-disk caches by their sources.
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);